@@ -0,0 +1,652 @@
+#include "pch.h"
+
+#undef main
+#include "SoftwareRenderer.h"
+#include "Texture.h"
+#include "Camera.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace dae;
+
+// End-to-end benchmark of the software renderer
+// Replays the same camera path for every resolution and thread count, so runs can be compared between commits
+struct CameraPose
+{
+	Vector3 origin{};
+	float pitch{};
+	float yaw{};
+};
+
+struct Resolution
+{
+	int width{};
+	int height{};
+};
+
+struct BenchmarkOptions
+{
+	std::string modelPath{ "Resources/vehicle.obj" };
+	std::string diffusePath{ "Resources/vehicle_diffuse.png" };
+	std::string normalPath{ "Resources/vehicle_normal.png" };
+	std::string specularPath{ "Resources/vehicle_specular.png" };
+	std::string glossinessPath{ "Resources/vehicle_gloss.png" };
+
+	// Empty uses the built-in orbit around the vehicle
+	std::string pathFile{};
+
+	std::string csvPath{ "benchmark_results.csv" };
+	std::string jsonPath{ "benchmark_results.json" };
+
+	std::vector<Resolution> resolutions{ { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+	std::vector<uint32_t> threadCounts{};
+
+	// Weak scaling, the pixel count grows with the thread count from this size at the lowest thread count
+	bool useWeakScaling{ true };
+	Resolution weakBaseResolution{ 640, 480 };
+
+	int frameCount{ 200 };
+	int warmupCount{ 20 };
+
+	// Radians the vehicle turns between frames
+	float rotationStep{ 0.01f };
+
+	bool useMsaa{ false };
+
+	// Toggles of the shading rate, 0 full, 1 adaptive, 2 coarse
+	int shadingRateIdx{};
+
+	// 1 keeps the frame in the backBuffer, 2 or 3 run the present ring against an offscreen front buffer
+	uint32_t presentBufferCount{ 1 };
+
+	// Dynamic resolution towards this frame time, 0 renders at the full resolution
+	float targetFrameMs{};
+};
+
+struct BenchmarkResult
+{
+	// Strong scaling keeps the resolution per thread count, weak scaling grows it with the thread count
+	bool isWeakScaling{ false };
+
+	Resolution resolution{};
+	uint32_t threadCount{};
+
+	double meanMs{};
+	double medianMs{};
+	double p99Ms{};
+	double minMs{};
+	double maxMs{};
+
+	// Mean of every stage
+	SoftwareRenderer::FrameTimings stageMs{};
+
+	// Mean shading work and internal resolution per frame
+	double shadedPixels{};
+	double resolutionScale{};
+
+	// Mean submit to on screen, the present itself without a ring
+	double presentLatencyMs{};
+
+	// Strong: against the lowest thread count at the same resolution
+	// Weak: efficiency is time(base threads, base size) / time(N threads, N / base threads times the size), speedup the scaled speedup
+	double speedup{};
+	double efficiency{};
+};
+
+// -- Arguments -- //
+
+void PrintUsage()
+{
+	std::cout << "Usage: SoftwareRasterizerBenchmark [options]" << std::endl;
+	std::cout << '\t' << "--model <path>" << '\t' << '\t' << "OBJ file (Resources/vehicle.obj)" << std::endl;
+	std::cout << '\t' << "--diffuse <path>" << '\t' << "Diffuse texture (Resources/vehicle_diffuse.png)" << std::endl;
+	std::cout << '\t' << "--normal <path>" << '\t' << '\t' << "Normal texture (Resources/vehicle_normal.png)" << std::endl;
+	std::cout << '\t' << "--specular <path>" << '\t' << "Specular texture (Resources/vehicle_specular.png)" << std::endl;
+	std::cout << '\t' << "--gloss <path>" << '\t' << '\t' << "Glossiness texture (Resources/vehicle_gloss.png)" << std::endl;
+	std::cout << '\t' << "--path <file>" << '\t' << '\t' << "Camera keyframes, one \"x y z pitch yaw\" per line in degrees (built-in orbit)" << std::endl;
+	std::cout << '\t' << "--resolutions <list>" << '\t' << "Comma separated WIDTHxHEIGHT (640x480,1280x720,1920x1080)" << std::endl;
+	std::cout << '\t' << "--threads <list>" << '\t' << "Comma separated thread counts (powers of two up to the hardware threads)" << std::endl;
+	std::cout << '\t' << "--weak <0|1>" << '\t' << '\t' << "Weak scaling sweep, pixels grow with the thread count (1)" << std::endl;
+	std::cout << '\t' << "--weak-base <WxH>" << '\t' << "Weak scaling size at the first thread count (640x480)" << std::endl;
+	std::cout << '\t' << "--frames <count>" << '\t' << "Measured frames per configuration (200)" << std::endl;
+	std::cout << '\t' << "--warmup <count>" << '\t' << "Unmeasured frames before that (20)" << std::endl;
+	std::cout << '\t' << "--spin <radians>" << '\t' << "Vehicle rotation per frame (0.01)" << std::endl;
+	std::cout << '\t' << "--msaa <0|1>" << '\t' << '\t' << "Render with 4x MSAA (0)" << std::endl;
+	std::cout << '\t' << "--shading-rate <full|adaptive|2x2>" << '\t' << "Variable-rate shading mode (full)" << std::endl;
+	std::cout << '\t' << "--present-buffers <1-3>" << '\t' << "Back buffers presented by a separate thread, 1 for none (1)" << std::endl;
+	std::cout << '\t' << "--target-ms <ms>" << '\t' << "Dynamic resolution towards this frame time, 0 for off (0)" << std::endl;
+	std::cout << '\t' << "--csv <path>" << '\t' << '\t' << "CSV report (benchmark_results.csv)" << std::endl;
+	std::cout << '\t' << "--json <path>" << '\t' << '\t' << "JSON report (benchmark_results.json)" << std::endl;
+}
+
+bool ParseResolutions(const char* value, std::vector<Resolution>& resolutions)
+{
+	resolutions.clear();
+
+	std::stringstream stream{ value };
+	std::string entry{};
+	while (std::getline(stream, entry, ','))
+	{
+		Resolution resolution{};
+		if (std::sscanf(entry.c_str(), "%dx%d", &resolution.width, &resolution.height) != 2
+			|| resolution.width <= 0 || resolution.height <= 0)
+		{
+			std::cout << "Invalid resolution " << entry << std::endl;
+			return false;
+		}
+		resolutions.push_back(resolution);
+	}
+
+	return resolutions.empty() == false;
+}
+
+bool ParseThreadCounts(const char* value, std::vector<uint32_t>& threadCounts)
+{
+	threadCounts.clear();
+
+	std::stringstream stream{ value };
+	std::string entry{};
+	while (std::getline(stream, entry, ','))
+	{
+		const int threadCount{ std::atoi(entry.c_str()) };
+		if (threadCount <= 0)
+		{
+			std::cout << "Invalid thread count " << entry << std::endl;
+			return false;
+		}
+		threadCounts.push_back(static_cast<uint32_t>(threadCount));
+	}
+
+	return threadCounts.empty() == false;
+}
+
+bool ParseArguments(int argc, char* args[], BenchmarkOptions& options)
+{
+	for (int argIdx{ 1 }; argIdx < argc; ++argIdx)
+	{
+		const std::string option{ args[argIdx] };
+		if (option == "--help")
+		{
+			return false;
+		}
+
+		// Every option takes exactly one value
+		if (argIdx + 1 >= argc)
+		{
+			std::cout << "Missing value for " << option << std::endl;
+			return false;
+		}
+		const char* value{ args[++argIdx] };
+
+		if (option == "--model") options.modelPath = value;
+		else if (option == "--diffuse") options.diffusePath = value;
+		else if (option == "--normal") options.normalPath = value;
+		else if (option == "--specular") options.specularPath = value;
+		else if (option == "--gloss") options.glossinessPath = value;
+		else if (option == "--path") options.pathFile = value;
+		else if (option == "--frames") options.frameCount = std::atoi(value);
+		else if (option == "--warmup") options.warmupCount = std::atoi(value);
+		else if (option == "--spin") options.rotationStep = static_cast<float>(std::atof(value));
+		else if (option == "--msaa") options.useMsaa = std::atoi(value) != 0;
+		else if (option == "--present-buffers") options.presentBufferCount = static_cast<uint32_t>(std::atoi(value));
+		else if (option == "--shading-rate")
+		{
+			if (std::strcmp(value, "full") == 0) options.shadingRateIdx = 0;
+			else if (std::strcmp(value, "adaptive") == 0) options.shadingRateIdx = 1;
+			else if (std::strcmp(value, "2x2") == 0) options.shadingRateIdx = 2;
+			else
+			{
+				std::cout << "Unknown shading rate " << value << std::endl;
+				return false;
+			}
+		}
+		else if (option == "--target-ms") options.targetFrameMs = static_cast<float>(std::atof(value));
+		else if (option == "--csv") options.csvPath = value;
+		else if (option == "--json") options.jsonPath = value;
+		else if (option == "--resolutions")
+		{
+			if (ParseResolutions(value, options.resolutions) == false) return false;
+		}
+		else if (option == "--threads")
+		{
+			if (ParseThreadCounts(value, options.threadCounts) == false) return false;
+		}
+		else if (option == "--weak") options.useWeakScaling = std::atoi(value) != 0;
+		else if (option == "--weak-base")
+		{
+			std::vector<Resolution> weakBaseResolutions{};
+			if (ParseResolutions(value, weakBaseResolutions) == false || weakBaseResolutions.size() != 1) return false;
+			options.weakBaseResolution = weakBaseResolutions.front();
+		}
+		else
+		{
+			std::cout << "Unknown option " << option << std::endl;
+			return false;
+		}
+	}
+
+	if (options.frameCount <= 0 || options.warmupCount < 0)
+	{
+		std::cout << "Frames has to be positive and warmup can't be negative" << std::endl;
+		return false;
+	}
+
+	// Powers of two, and every hardware thread as the last step
+	if (options.threadCounts.empty())
+	{
+		const uint32_t hardwareThreads{ std::max(std::thread::hardware_concurrency(), 1u) };
+		for (uint32_t threadCount{ 1 }; threadCount < hardwareThreads; threadCount *= 2)
+		{
+			options.threadCounts.push_back(threadCount);
+		}
+		options.threadCounts.push_back(hardwareThreads);
+	}
+
+	return true;
+}
+
+// -- Camera Path -- //
+
+CameraPose CreateLookAtPose(const Vector3& origin, const Vector3& target)
+{
+	// Inverse of the forward vector Camera builds from pitch and yaw
+	const Vector3 toTarget{ (target - origin).Normalized() };
+
+	CameraPose pose{};
+	pose.origin = origin;
+	pose.pitch = std::asin(toTarget.y) * TO_DEGREES;
+	pose.yaw = std::atan2(toTarget.x, toTarget.z) * TO_DEGREES;
+	return pose;
+}
+
+std::vector<CameraPose> CreateDefaultPath()
+{
+	// The vehicle sits at 50 units in front of the origin, same as Renderer
+	const Vector3 vehiclePosition{ 0.f, 0.f, 50.f };
+	const std::vector<Vector3> origins{
+		{ 0.f, 0.f, 0.f },			// Start view of the interactive build
+		{ 0.f, 4.f, 28.f },			// Close-up, vehicle fills the screen
+		{ 30.f, 12.f, 30.f },
+		{ 45.f, 20.f, 55.f },		// Side view from above
+		{ 14.f, 3.f, 62.f },		// Close-up, very large triangles
+		{ -20.f, 8.f, 85.f },		// Behind, vehicle far away
+		{ -35.f, 10.f, 40.f },
+		{ 0.f, 0.f, 0.f },
+	};
+
+	std::vector<CameraPose> poses{};
+	for (const Vector3& origin : origins)
+	{
+		CameraPose pose{ CreateLookAtPose(origin, vehiclePosition) };
+
+		// Keep yaw continuous, otherwise interpolating spins the long way around
+		if (poses.empty() == false)
+		{
+			const float previousYaw{ poses.back().yaw };
+			while (pose.yaw - previousYaw > 180.f) pose.yaw -= 360.f;
+			while (pose.yaw - previousYaw < -180.f) pose.yaw += 360.f;
+		}
+		poses.push_back(pose);
+	}
+
+	return poses;
+}
+
+bool LoadPath(const std::string& fileName, std::vector<CameraPose>& poses)
+{
+	std::ifstream file{ fileName };
+	if (!file)
+	{
+		std::cout << "Failed to open camera path " << fileName << std::endl;
+		return false;
+	}
+
+	std::string line{};
+	while (std::getline(file, line))
+	{
+		// Comments and empty lines
+		const size_t firstCharacter{ line.find_first_not_of(" \t\r") };
+		if (firstCharacter == std::string::npos || line[firstCharacter] == '#') continue;
+
+		std::stringstream lineStream{ line };
+		CameraPose pose{};
+		if (!(lineStream >> pose.origin.x >> pose.origin.y >> pose.origin.z >> pose.pitch >> pose.yaw))
+		{
+			std::cout << "Invalid camera keyframe: " << line << std::endl;
+			return false;
+		}
+		poses.push_back(pose);
+	}
+
+	if (poses.empty())
+	{
+		std::cout << "Camera path " << fileName << " has no keyframes" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+CameraPose SamplePath(const std::vector<CameraPose>& poses, int frameIdx, int frameCount)
+{
+	if (poses.size() == 1 || frameCount <= 1) return poses.front();
+
+	// Keyframes are spread evenly over the measured frames
+	const float pathPosition{ frameIdx / static_cast<float>(frameCount - 1) * (poses.size() - 1) };
+	const size_t keyIdx{ std::min(static_cast<size_t>(pathPosition), poses.size() - 2) };
+	const float t{ pathPosition - keyIdx };
+
+	const CameraPose& from{ poses[keyIdx] };
+	const CameraPose& to{ poses[keyIdx + 1] };
+
+	CameraPose pose{};
+	pose.origin = from.origin + (to.origin - from.origin) * t;
+	pose.pitch = Lerpf(from.pitch, to.pitch, t);
+	pose.yaw = Lerpf(from.yaw, to.yaw, t);
+	return pose;
+}
+
+// -- Statistics -- //
+
+BenchmarkResult Summarize(std::vector<double>& frameMilliseconds, const std::vector<SoftwareRenderer::FrameTimings>& frameTimings)
+{
+	BenchmarkResult result{};
+
+	std::sort(frameMilliseconds.begin(), frameMilliseconds.end());
+	const size_t frameCount{ frameMilliseconds.size() };
+
+	double totalMilliseconds{};
+	for (double milliseconds : frameMilliseconds)
+	{
+		totalMilliseconds += milliseconds;
+	}
+
+	result.meanMs = totalMilliseconds / frameCount;
+	result.medianMs = (frameCount % 2 == 1)
+		? frameMilliseconds[frameCount / 2]
+		: (frameMilliseconds[frameCount / 2 - 1] + frameMilliseconds[frameCount / 2]) * 0.5;
+	result.minMs = frameMilliseconds.front();
+	result.maxMs = frameMilliseconds.back();
+
+	// Nearest rank
+	const size_t p99Rank{ static_cast<size_t>(std::ceil(0.99 * frameCount)) };
+	result.p99Ms = frameMilliseconds[std::max(p99Rank, size_t{ 1 }) - 1];
+
+	for (const SoftwareRenderer::FrameTimings& timings : frameTimings)
+	{
+		result.stageMs.clearMs += timings.clearMs / frameCount;
+		result.stageMs.transformMs += timings.transformMs / frameCount;
+		result.stageMs.setupMs += timings.setupMs / frameCount;
+		result.stageMs.rasterMs += timings.rasterMs / frameCount;
+		result.stageMs.deferredShadeMs += timings.deferredShadeMs / frameCount;
+		result.stageMs.resolveMs += timings.resolveMs / frameCount;
+		result.stageMs.upscaleMs += timings.upscaleMs / frameCount;
+		result.stageMs.presentMs += timings.presentMs / frameCount;
+		result.stageMs.totalMs += timings.totalMs / frameCount;
+	}
+
+	return result;
+}
+
+// -- Reports -- //
+
+bool WriteCsv(const std::string& fileName, const std::vector<BenchmarkResult>& results)
+{
+	std::ofstream file{ fileName };
+	if (!file) return false;
+
+	file << "sweep,width,height,threads,pixels_per_thread,mean_ms,median_ms,p99_ms,min_ms,max_ms,"
+		<< "clear_ms,transform_ms,setup_ms,raster_ms,deferred_shade_ms,resolve_ms,upscale_ms,present_ms,present_latency_ms,shaded_pixels,resolution_scale,speedup,efficiency\n";
+
+	for (const BenchmarkResult& result : results)
+	{
+		const int pixelCount{ result.resolution.width * result.resolution.height };
+		file << (result.isWeakScaling ? "weak" : "strong") << ','
+			<< result.resolution.width << ',' << result.resolution.height << ',' << result.threadCount << ','
+			<< pixelCount / result.threadCount << ','
+			<< result.meanMs << ',' << result.medianMs << ',' << result.p99Ms << ',' << result.minMs << ',' << result.maxMs << ','
+			<< result.stageMs.clearMs << ',' << result.stageMs.transformMs << ',' << result.stageMs.setupMs << ','
+			<< result.stageMs.rasterMs << ',' << result.stageMs.deferredShadeMs << ',' << result.stageMs.resolveMs << ','
+			<< result.stageMs.upscaleMs << ',' << result.stageMs.presentMs << ',' << result.presentLatencyMs << ',' << result.shadedPixels << ',' << result.resolutionScale << ',' << result.speedup << ',' << result.efficiency << '\n';
+	}
+
+	return file.good();
+}
+
+std::string EscapeJson(const std::string& text)
+{
+	std::string escapedText{};
+	for (char character : text)
+	{
+		if (character == '"' || character == '\\') escapedText += '\\';
+		escapedText += character;
+	}
+	return escapedText;
+}
+
+bool WriteJson(const std::string& fileName, const BenchmarkOptions& options, size_t keyframeCount, const std::vector<BenchmarkResult>& results)
+{
+	std::ofstream file{ fileName };
+	if (!file) return false;
+
+	file << "{\n";
+	file << "\t\"model\": \"" << EscapeJson(options.modelPath) << "\",\n";
+	file << "\t\"cameraPath\": \"" << (options.pathFile.empty() ? "built-in" : EscapeJson(options.pathFile)) << "\",\n";
+	file << "\t\"keyframes\": " << keyframeCount << ",\n";
+	file << "\t\"frames\": " << options.frameCount << ",\n";
+	file << "\t\"warmup\": " << options.warmupCount << ",\n";
+	file << "\t\"spin\": " << options.rotationStep << ",\n";
+	file << "\t\"msaa\": " << (options.useMsaa ? "true" : "false") << ",\n";
+	file << "\t\"presentBuffers\": " << options.presentBufferCount << ",\n";
+	file << "\t\"shadingRate\": \"" << (options.shadingRateIdx == 0 ? "full" : options.shadingRateIdx == 1 ? "adaptive" : "2x2") << "\",\n";
+	file << "\t\"targetMs\": " << options.targetFrameMs << ",\n";
+	file << "\t\"results\": [\n";
+
+	for (size_t resultIdx{}; resultIdx < results.size(); ++resultIdx)
+	{
+		const BenchmarkResult& result{ results[resultIdx] };
+		const int pixelCount{ result.resolution.width * result.resolution.height };
+
+		file << "\t\t{\n";
+		file << "\t\t\t\"sweep\": \"" << (result.isWeakScaling ? "weak" : "strong") << "\",\n";
+		file << "\t\t\t\"width\": " << result.resolution.width << ", \"height\": " << result.resolution.height
+			<< ", \"threads\": " << result.threadCount << ", \"pixelsPerThread\": " << pixelCount / result.threadCount << ",\n";
+		file << "\t\t\t\"meanMs\": " << result.meanMs << ", \"medianMs\": " << result.medianMs << ", \"p99Ms\": " << result.p99Ms
+			<< ", \"minMs\": " << result.minMs << ", \"maxMs\": " << result.maxMs << ",\n";
+		file << "\t\t\t\"stagesMs\": { \"clear\": " << result.stageMs.clearMs << ", \"transform\": " << result.stageMs.transformMs
+			<< ", \"setup\": " << result.stageMs.setupMs << ", \"raster\": " << result.stageMs.rasterMs
+			<< ", \"deferredShade\": " << result.stageMs.deferredShadeMs << ", \"resolve\": " << result.stageMs.resolveMs
+			<< ", \"upscale\": " << result.stageMs.upscaleMs << ", \"present\": " << result.stageMs.presentMs << " },\n";
+		file << "\t\t\t\"shadedPixels\": " << result.shadedPixels << ", \"resolutionScale\": " << result.resolutionScale
+			<< ", \"presentLatencyMs\": " << result.presentLatencyMs << ",\n";
+		file << "\t\t\t\"speedup\": " << result.speedup << ", \"efficiency\": " << result.efficiency << "\n";
+		file << "\t\t}" << (resultIdx + 1 < results.size() ? "," : "") << "\n";
+	}
+
+	file << "\t]\n";
+	file << "}\n";
+
+	return file.good();
+}
+
+// -- Main -- //
+
+int main(int argc, char* args[])
+{
+	BenchmarkOptions options{};
+	if (ParseArguments(argc, args, options) == false)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// Scopes would only add to the frame times
+	Profiler::SetRecording(false);
+
+	std::vector<CameraPose> cameraPath{};
+	if (options.pathFile.empty()) cameraPath = CreateDefaultPath();
+	else if (LoadPath(options.pathFile, cameraPath) == false) return 1;
+
+	// Model and textures, same assets as the interactive build
+	std::vector<VS_INPUT> vertices{};
+	std::vector<uint32_t> indices{};
+	if (Utils::ParseOBJ(options.modelPath, vertices, indices) == false)
+	{
+		std::cout << "Failed to load model " << options.modelPath << std::endl;
+		return 1;
+	}
+
+	Texture diffuseTexture{ options.diffusePath.c_str() };
+	Texture normalTexture{ options.normalPath.c_str() };
+	Texture specularTexture{ options.specularPath.c_str() };
+	Texture glossinessTexture{ options.glossinessPath.c_str() };
+	if (!diffuseTexture.IsLoaded() || !normalTexture.IsLoaded() || !specularTexture.IsLoaded() || !glossinessTexture.IsLoaded())
+	{
+		std::cout << "Failed to load textures" << std::endl;
+		return 1;
+	}
+
+	// One renderer per resolution, every thread count renders the same path with it
+	const auto measureResolution = [&](const Resolution& resolution, const std::vector<uint32_t>& threadCounts, bool isWeakScaling, std::vector<BenchmarkResult>& results)
+		{
+			Camera camera{ resolution.width / static_cast<float>(resolution.height), { 0,0,0.f }, 45.f };
+			Matrix worldMatrix{};
+			bool useClearColorBackground{ false };
+			CullingMode cullingMode{ backFace };
+
+			SoftwareRenderer softwareRenderer{
+				nullptr, resolution.width, resolution.height,
+				vertices, indices,
+				&diffuseTexture, &normalTexture, &specularTexture, &glossinessTexture,
+				&camera,
+				&worldMatrix, &useClearColorBackground, &cullingMode };
+			if (options.useMsaa) softwareRenderer.ToggleMsaa();
+			for (int toggleIdx{}; toggleIdx < options.shadingRateIdx; ++toggleIdx) softwareRenderer.ToggleShadingRate();
+			softwareRenderer.SetPresentBufferCount(options.presentBufferCount);
+			if (options.targetFrameMs > 0.f)
+			{
+				softwareRenderer.SetTargetFrameTime(options.targetFrameMs);
+				softwareRenderer.ToggleDynamicResolution();
+			}
+
+			for (uint32_t threadCount : threadCounts)
+			{
+				softwareRenderer.SetThreadCount(threadCount);
+
+				// New frame cost, the warmup frames give the scale time to settle
+				if (options.targetFrameMs > 0.f) softwareRenderer.SetTargetFrameTime(options.targetFrameMs);
+
+				std::vector<double> frameMilliseconds{};
+				std::vector<SoftwareRenderer::FrameTimings> frameTimings{};
+				frameMilliseconds.reserve(options.frameCount);
+				frameTimings.reserve(options.frameCount);
+				uint64_t shadedPixels{};
+				double resolutionScale{};
+				double presentLatencyMs{};
+
+				// Warmup replays the start of the path, measured frames the whole path
+				for (int frameIdx{ -options.warmupCount }; frameIdx < options.frameCount; ++frameIdx)
+				{
+					const int pathFrameIdx{ std::max(frameIdx, 0) };
+					const CameraPose pose{ SamplePath(cameraPath, pathFrameIdx, options.frameCount) };
+					camera.SetPose(pose.origin, pose.pitch, pose.yaw);
+
+					const Matrix translationMatrix{ Matrix::CreateTranslation(0.f, 0.f, 50.f) };
+					const Matrix rotationMatrix{ Matrix::CreateRotationY(options.rotationStep * pathFrameIdx) };
+					worldMatrix = rotationMatrix * translationMatrix;
+					softwareRenderer.Update(nullptr);
+
+					softwareRenderer.Render();
+					if (frameIdx < 0) continue;
+
+					const SoftwareRenderer::FrameTimings& timings{ softwareRenderer.GetFrameTimings() };
+					frameMilliseconds.push_back(timings.totalMs);
+					frameTimings.push_back(timings);
+					shadedPixels += softwareRenderer.GetShadingStatistics().shadedPixels;
+					resolutionScale += softwareRenderer.GetResolutionScale();
+					presentLatencyMs += softwareRenderer.GetPresentLatencyMs();
+				}
+
+				BenchmarkResult result{ Summarize(frameMilliseconds, frameTimings) };
+				result.isWeakScaling = isWeakScaling;
+				result.shadedPixels = static_cast<double>(shadedPixels) / options.frameCount;
+				result.resolutionScale = resolutionScale / options.frameCount;
+				result.presentLatencyMs = presentLatencyMs / options.frameCount;
+				result.resolution = resolution;
+				result.threadCount = softwareRenderer.GetThreadCount();
+				results.push_back(result);
+			}
+		};
+
+	const auto printResult = [](const BenchmarkResult& result)
+		{
+			std::cout << (result.isWeakScaling ? "Weak " : "") << result.resolution.width << "x" << result.resolution.height << " on " << result.threadCount << " threads: "
+				<< "mean " << result.meanMs << " ms, median " << result.medianMs << " ms, p99 " << result.p99Ms << " ms, "
+				<< (result.isWeakScaling ? "weak efficiency " : "speedup ") << (result.isWeakScaling ? result.efficiency : result.speedup) << std::endl;
+		};
+
+	// Strong scaling, same frame on more threads
+	std::vector<BenchmarkResult> results{};
+	for (const Resolution& resolution : options.resolutions)
+	{
+		const size_t firstResultIdx{ results.size() };
+		measureResolution(resolution, options.threadCounts, false, results);
+
+		const BenchmarkResult& baseResult{ results[firstResultIdx] };
+		for (size_t resultIdx{ firstResultIdx }; resultIdx < results.size(); ++resultIdx)
+		{
+			BenchmarkResult& result{ results[resultIdx] };
+			result.speedup = baseResult.meanMs / result.meanMs;
+			result.efficiency = result.speedup * baseResult.threadCount / result.threadCount;
+			printResult(result);
+		}
+	}
+
+	// Weak scaling, N times the threads get N times the pixels at the same aspect ratio
+	// Sizes round to whole pixels, so the efficiency is corrected for the pixel count that was actually rendered
+	if (options.useWeakScaling)
+	{
+		const size_t firstResultIdx{ results.size() };
+		const uint32_t baseThreadCount{ options.threadCounts.front() };
+		for (uint32_t threadCount : options.threadCounts)
+		{
+			const double axisScale{ std::sqrt(static_cast<double>(threadCount) / baseThreadCount) };
+			const Resolution resolution{ std::max(static_cast<int>(std::lround(options.weakBaseResolution.width * axisScale)), 1),
+				std::max(static_cast<int>(std::lround(options.weakBaseResolution.height * axisScale)), 1) };
+			measureResolution(resolution, { threadCount }, true, results);
+		}
+
+		const BenchmarkResult& baseResult{ results[firstResultIdx] };
+		const double basePixelsPerThread{ static_cast<double>(baseResult.resolution.width) * baseResult.resolution.height / baseResult.threadCount };
+		for (size_t resultIdx{ firstResultIdx }; resultIdx < results.size(); ++resultIdx)
+		{
+			BenchmarkResult& result{ results[resultIdx] };
+			const double pixelsPerThread{ static_cast<double>(result.resolution.width) * result.resolution.height / result.threadCount };
+			result.efficiency = baseResult.meanMs / result.meanMs * pixelsPerThread / basePixelsPerThread;
+			result.speedup = result.efficiency * result.threadCount / baseResult.threadCount;
+			printResult(result);
+		}
+	}
+
+	if (WriteCsv(options.csvPath, results) == false)
+	{
+		std::cout << "Failed to write " << options.csvPath << std::endl;
+		return 1;
+	}
+	if (WriteJson(options.jsonPath, options, cameraPath.size(), results) == false)
+	{
+		std::cout << "Failed to write " << options.jsonPath << std::endl;
+		return 1;
+	}
+
+	std::cout << "Wrote " << options.csvPath << " and " << options.jsonPath << std::endl;
+	return 0;
+}
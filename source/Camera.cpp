@@ -8,6 +8,8 @@ Camera::Camera(float aspectRatio, const dae::Vector3& origin, float fovAngle)
 {
 	m_Fov = tanf((fovAngle * dae::TO_RADIANS) / 2.f);
 
+	// Usable right away, without waiting for the first Update
+	CalculateViewMatrix();
 	CalculateProjectionMatrix();
 }
 
@@ -43,6 +45,19 @@ void Camera::Update(const dae::Timer* pTimer)
 	}
 }
 
+void Camera::SetPose(const dae::Vector3& origin, float pitch, float yaw)
+{
+	m_Origin = origin;
+	m_TotalPitch = pitch;
+	m_TotalYaw = yaw;
+
+	const dae::Matrix rotationMatrix{ dae::Matrix::CreateRotation(m_TotalPitch * dae::TO_RADIANS,m_TotalYaw * dae::TO_RADIANS,0) };
+	m_ForwardVector = rotationMatrix.TransformVector(dae::Vector3::UnitZ);
+	m_ForwardVector.Normalize();
+
+	CalculateViewMatrix();
+}
+
 dae::Matrix Camera::GetInvViewMatrix() const
 {
 	return m_InvViewMatrix;
@@ -18,6 +18,9 @@ public:
 	// Public Functions
 	void Update(const dae::Timer* pTimer);
 
+	// Scripted placement, pitch and yaw in degrees like the mouse input
+	void SetPose(const dae::Vector3& origin, float pitch, float yaw);
+
 	dae::Matrix GetInvViewMatrix() const;
 	dae::Matrix GetProjectionMatrix() const;
 
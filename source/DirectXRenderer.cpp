@@ -138,6 +138,8 @@ namespace dae {
 		if (!m_IsInitialized)
 			return;
 
+		DAE_PROFILE_SCOPE("DirectXRenderer::Render");
+
 		// 1. CLEAR RTV & DSV
 		ColorRGB clearColor{};
 
@@ -160,7 +162,10 @@ namespace dae {
 
 
 		// 3. PRESENT BACKBUFFER (SWAP)
-		m_pSwapChain->Present(0, 0);
+		{
+			DAE_PROFILE_SCOPE("DirectXRenderer::Present");
+			m_pSwapChain->Present(0, 0);
+		}
 	}
 
 	void DirectXRenderer::ToggleFireFX()
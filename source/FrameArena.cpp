@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "FrameArena.h"
+
+#include <new>
+
+namespace dae
+{
+	FrameArena::FrameArena(size_t initialCapacity)
+	{
+		if (initialCapacity > 0)
+		{
+			m_pBlock = CreateBlock(initialCapacity);
+			m_Capacity = initialCapacity;
+		}
+	}
+	FrameArena::~FrameArena()
+	{
+		for (std::byte* pBlock : m_pOverflowBlocks)
+		{
+			DeleteBlock(pBlock);
+		}
+		DeleteBlock(m_pBlock);
+	}
+
+	void FrameArena::Reset()
+	{
+		// Didn't fit last frame, make the block big enough for everything at once
+		if (!m_pOverflowBlocks.empty())
+		{
+			for (std::byte* pBlock : m_pOverflowBlocks)
+			{
+				DeleteBlock(pBlock);
+			}
+			m_pOverflowBlocks.clear();
+			m_OverflowSize = 0;
+
+			// Some headroom, so slowly growing scenes don't reallocate every frame
+			DeleteBlock(m_pBlock);
+			m_Capacity = m_PeakSize + m_PeakSize / 2;
+			m_pBlock = CreateBlock(m_Capacity);
+		}
+
+		m_Offset = 0;
+	}
+
+	void* FrameArena::AllocateBytes(size_t size, size_t alignment)
+	{
+		// Bump the offset in the main block
+		const size_t alignedOffset{ (m_Offset + alignment - 1) & ~(alignment - 1) };
+		if (alignedOffset + size <= m_Capacity)
+		{
+			m_Offset = alignedOffset + size;
+			m_PeakSize = std::max(m_PeakSize, m_Offset + m_OverflowSize);
+			return m_pBlock + alignedOffset;
+		}
+
+		// Out of space, give this allocation its own block until the next Reset
+		std::byte* pBlock{ CreateBlock(size) };
+		m_pOverflowBlocks.push_back(pBlock);
+		m_OverflowSize += size + alignment;
+		m_PeakSize = std::max(m_PeakSize, m_Offset + m_OverflowSize);
+		return pBlock;
+	}
+
+	std::byte* FrameArena::CreateBlock(size_t size)
+	{
+		return static_cast<std::byte*>(::operator new(std::max(size, size_t{ 1 }), std::align_val_t{ m_BlockAlignment }));
+	}
+	void FrameArena::DeleteBlock(std::byte* pBlock)
+	{
+		if (pBlock == nullptr) return;
+		::operator delete(pBlock, std::align_val_t{ m_BlockAlignment });
+	}
+}
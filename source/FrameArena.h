@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace dae
+{
+	// Linear allocator for data that only lives for one frame
+	// Reset() hands everything back at once and grows the block to the last peak, so steady frames never allocate
+	class FrameArena final
+	{
+	public:
+		// Constructor and Destructor
+		explicit FrameArena(size_t initialCapacity = 0);
+		~FrameArena();
+
+		// Rule of Five
+		FrameArena(const FrameArena&) = delete;
+		FrameArena(FrameArena&&) noexcept = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+		FrameArena& operator=(FrameArena&&) noexcept = delete;
+
+		// Public functions
+		// Memory is not initialized and nothing gets destroyed, so only plain data goes in here
+		template<typename T>
+		T* Allocate(size_t count)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "FrameArena never runs destructors");
+			return static_cast<T*>(AllocateBytes(sizeof(T) * count, alignof(T)));
+		}
+
+		void Reset();
+
+		size_t GetCapacity() const { return m_Capacity; }
+		size_t GetPeakSize() const { return m_PeakSize; }
+
+	private:
+		static constexpr size_t m_BlockAlignment{ 64 };
+
+		std::byte* m_pBlock{ nullptr };
+		size_t m_Capacity{};
+		size_t m_Offset{};
+
+		// Only used while the arena is still warming up
+		std::vector<std::byte*> m_pOverflowBlocks{};
+		size_t m_OverflowSize{};
+		size_t m_PeakSize{};
+
+		// Member Functions
+		void* AllocateBytes(size_t size, size_t alignment);
+
+		static std::byte* CreateBlock(size_t size);
+		static void DeleteBlock(std::byte* pBlock);
+	};
+}
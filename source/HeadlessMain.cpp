@@ -0,0 +1,283 @@
+#include "pch.h"
+
+#undef main
+#include "SoftwareRenderer.h"
+#include "Texture.h"
+#include "Camera.h"
+#include "Utils.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace dae;
+
+// Batch rendering without a window or GPU, only the software renderer
+// Every option has a default, so running it from the source directory renders the vehicle once
+struct HeadlessOptions
+{
+	std::string modelPath{ "Resources/vehicle.obj" };
+	std::string diffusePath{ "Resources/vehicle_diffuse.png" };
+	std::string normalPath{ "Resources/vehicle_normal.png" };
+	std::string specularPath{ "Resources/vehicle_specular.png" };
+	std::string glossinessPath{ "Resources/vehicle_gloss.png" };
+
+	// Empty keeps the frames in memory
+	std::string outputPrefix{};
+	std::string outputFormat{ "bmp" };
+
+	// Chrome trace of the whole run, needs DAE_PROFILING
+	std::string traceFileName{};
+
+	int width{ 640 };
+	int height{ 480 };
+	int frameCount{ 1 };
+	uint32_t threadCount{};
+
+	// Radians the vehicle turns between frames
+	float rotationStep{};
+	CullingMode cullingMode{ backFace };
+	bool useMsaa{ false };
+
+	// Toggles of the shading rate, 0 full, 1 adaptive, 2 coarse
+	int shadingRateIdx{};
+
+	// Toggles of the heatmap, 0 off, 1 overdraw, 2 depth-test failures, 3 tile cost
+	int heatmapIdx{};
+
+	// 1 keeps the frame in the backBuffer, 2 or 3 run the present ring against an offscreen front buffer
+	uint32_t presentBufferCount{ 1 };
+
+	// Fixed internal resolution, or a frame time to scale towards when the target is set
+	float resolutionScale{ 1.f };
+	float targetFrameMs{};
+};
+
+void PrintUsage()
+{
+	std::cout << "Usage: SoftwareRasterizerCli [options]" << std::endl;
+	std::cout << '\t' << "--model <path>" << '\t' << '\t' << "OBJ file (Resources/vehicle.obj)" << std::endl;
+	std::cout << '\t' << "--diffuse <path>" << '\t' << "Diffuse texture (Resources/vehicle_diffuse.png)" << std::endl;
+	std::cout << '\t' << "--normal <path>" << '\t' << '\t' << "Normal texture (Resources/vehicle_normal.png)" << std::endl;
+	std::cout << '\t' << "--specular <path>" << '\t' << "Specular texture (Resources/vehicle_specular.png)" << std::endl;
+	std::cout << '\t' << "--gloss <path>" << '\t' << '\t' << "Glossiness texture (Resources/vehicle_gloss.png)" << std::endl;
+	std::cout << '\t' << "--width <pixels>" << '\t' << "Output width (640)" << std::endl;
+	std::cout << '\t' << "--height <pixels>" << '\t' << "Output height (480)" << std::endl;
+	std::cout << '\t' << "--frames <count>" << '\t' << "Frames to render (1)" << std::endl;
+	std::cout << '\t' << "--threads <count>" << '\t' << "Worker threads, 0 for one per hardware thread (0)" << std::endl;
+	std::cout << '\t' << "--rotation <radians>" << '\t' << "Vehicle rotation per frame (0)" << std::endl;
+	std::cout << '\t' << "--cull <back|front|none>" << '\t' << "Culling mode (back)" << std::endl;
+	std::cout << '\t' << "--msaa <0|1>" << '\t' << '\t' << "Render with 4x MSAA (0)" << std::endl;
+	std::cout << '\t' << "--shading-rate <full|adaptive|2x2>" << '\t' << "Variable-rate shading mode (full)" << std::endl;
+	std::cout << '\t' << "--present-buffers <1-3>" << '\t' << "Back buffers presented by a separate thread, 1 for none (1)" << std::endl;
+	std::cout << '\t' << "--heatmap <off|overdraw|depth-fail|tile-cost>" << '\t' << "Write a heatmap instead of the shaded frame (off)" << std::endl;
+	std::cout << '\t' << "--scale <factor>" << '\t' << "Internal resolution per axis, upscaled to the output (1)" << std::endl;
+	std::cout << '\t' << "--target-ms <ms>" << '\t' << "Scale the internal resolution to hit this frame time, 0 for off (0)" << std::endl;
+	std::cout << '\t' << "--output <prefix>" << '\t' << "Write every frame to <prefix>_<frame>.<format>, frames stay in memory without it" << std::endl;
+	std::cout << '\t' << "--format <bmp|png>" << '\t' << "Image format for --output (bmp)" << std::endl;
+	std::cout << '\t' << "--trace <path>" << '\t' << '\t' << "Write a Chrome trace of startup and every frame, needs a DAE_PROFILING build" << std::endl;
+}
+
+bool ParseArguments(int argc, char* args[], HeadlessOptions& options)
+{
+	for (int argIdx{ 1 }; argIdx < argc; ++argIdx)
+	{
+		const std::string option{ args[argIdx] };
+		if (option == "--help")
+		{
+			return false;
+		}
+
+		// Every option takes exactly one value
+		if (argIdx + 1 >= argc)
+		{
+			std::cout << "Missing value for " << option << std::endl;
+			return false;
+		}
+		const char* value{ args[++argIdx] };
+
+		if (option == "--model") options.modelPath = value;
+		else if (option == "--diffuse") options.diffusePath = value;
+		else if (option == "--normal") options.normalPath = value;
+		else if (option == "--specular") options.specularPath = value;
+		else if (option == "--gloss") options.glossinessPath = value;
+		else if (option == "--width") options.width = std::atoi(value);
+		else if (option == "--height") options.height = std::atoi(value);
+		else if (option == "--frames") options.frameCount = std::atoi(value);
+		else if (option == "--threads") options.threadCount = static_cast<uint32_t>(std::atoi(value));
+		else if (option == "--rotation") options.rotationStep = static_cast<float>(std::atof(value));
+		else if (option == "--output") options.outputPrefix = value;
+		else if (option == "--format") options.outputFormat = value;
+		else if (option == "--trace") options.traceFileName = value;
+		else if (option == "--msaa") options.useMsaa = std::atoi(value) != 0;
+		else if (option == "--present-buffers") options.presentBufferCount = static_cast<uint32_t>(std::atoi(value));
+		else if (option == "--shading-rate")
+		{
+			if (std::strcmp(value, "full") == 0) options.shadingRateIdx = 0;
+			else if (std::strcmp(value, "adaptive") == 0) options.shadingRateIdx = 1;
+			else if (std::strcmp(value, "2x2") == 0) options.shadingRateIdx = 2;
+			else
+			{
+				std::cout << "Unknown shading rate " << value << std::endl;
+				return false;
+			}
+		}
+		else if (option == "--heatmap")
+		{
+			if (std::strcmp(value, "off") == 0) options.heatmapIdx = 0;
+			else if (std::strcmp(value, "overdraw") == 0) options.heatmapIdx = 1;
+			else if (std::strcmp(value, "depth-fail") == 0) options.heatmapIdx = 2;
+			else if (std::strcmp(value, "tile-cost") == 0) options.heatmapIdx = 3;
+			else
+			{
+				std::cout << "Unknown heatmap " << value << std::endl;
+				return false;
+			}
+		}
+		else if (option == "--scale") options.resolutionScale = static_cast<float>(std::atof(value));
+		else if (option == "--target-ms") options.targetFrameMs = static_cast<float>(std::atof(value));
+		else if (option == "--cull")
+		{
+			if (std::strcmp(value, "back") == 0) options.cullingMode = backFace;
+			else if (std::strcmp(value, "front") == 0) options.cullingMode = frontFace;
+			else if (std::strcmp(value, "none") == 0) options.cullingMode = noCulling;
+			else
+			{
+				std::cout << "Unknown culling mode " << value << std::endl;
+				return false;
+			}
+		}
+		else
+		{
+			std::cout << "Unknown option " << option << std::endl;
+			return false;
+		}
+	}
+
+	if (options.width <= 0 || options.height <= 0 || options.frameCount <= 0)
+	{
+		std::cout << "Width, height and frames have to be positive" << std::endl;
+		return false;
+	}
+
+	if (options.outputFormat != "bmp" && options.outputFormat != "png")
+	{
+		std::cout << "Unknown image format " << options.outputFormat << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char* args[])
+{
+	HeadlessOptions options{};
+	if (ParseArguments(argc, args, options) == false)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+#if defined(DAE_PROFILING)
+	Profiler::SetRecording(options.traceFileName.empty() == false);
+#else
+	if (options.traceFileName.empty() == false)
+	{
+		std::cout << "Built without DAE_PROFILING, no trace gets written" << std::endl;
+	}
+#endif
+	DAE_PROFILE_THREAD_NAME("Main");
+
+	// Model and textures, same assets as the interactive build
+	std::vector<VS_INPUT> vertices{};
+	std::vector<uint32_t> indices{};
+	if (Utils::ParseOBJ(options.modelPath, vertices, indices) == false)
+	{
+		std::cout << "Failed to load model " << options.modelPath << std::endl;
+		return 1;
+	}
+
+	Texture diffuseTexture{ options.diffusePath.c_str() };
+	Texture normalTexture{ options.normalPath.c_str() };
+	Texture specularTexture{ options.specularPath.c_str() };
+	Texture glossinessTexture{ options.glossinessPath.c_str() };
+	if (!diffuseTexture.IsLoaded() || !normalTexture.IsLoaded() || !specularTexture.IsLoaded() || !glossinessTexture.IsLoaded())
+	{
+		std::cout << "Failed to load textures" << std::endl;
+		return 1;
+	}
+
+	// Same camera and placement as Renderer
+	Camera camera{ options.width / static_cast<float>(options.height), { 0,0,0.f }, 45.f };
+	Matrix worldMatrix{};
+	bool useClearColorBackground{ false };
+	CullingMode cullingMode{ options.cullingMode };
+
+	SoftwareRenderer softwareRenderer{
+		nullptr, options.width, options.height,
+		vertices, indices,
+		&diffuseTexture, &normalTexture, &specularTexture, &glossinessTexture,
+		&camera,
+		&worldMatrix, &useClearColorBackground, &cullingMode };
+
+	if (options.threadCount > 0) softwareRenderer.SetThreadCount(options.threadCount);
+	if (options.useMsaa) softwareRenderer.ToggleMsaa();
+	for (int toggleIdx{}; toggleIdx < options.shadingRateIdx; ++toggleIdx) softwareRenderer.ToggleShadingRate();
+	for (int toggleIdx{}; toggleIdx < options.heatmapIdx; ++toggleIdx) softwareRenderer.ToggleHeatmap();
+	softwareRenderer.SetPresentBufferCount(options.presentBufferCount);
+	softwareRenderer.SetResolutionScale(options.resolutionScale);
+	if (options.targetFrameMs > 0.f)
+	{
+		softwareRenderer.SetTargetFrameTime(options.targetFrameMs);
+		softwareRenderer.ToggleDynamicResolution();
+	}
+
+	// Render
+	double totalMilliseconds{};
+	for (int frameIdx{}; frameIdx < options.frameCount; ++frameIdx)
+	{
+		const Matrix translationMatrix{ Matrix::CreateTranslation(0.f, 0.f, 50.f) };
+		const Matrix rotationMatrix{ Matrix::CreateRotationY(options.rotationStep * frameIdx) };
+		worldMatrix = rotationMatrix * translationMatrix;
+		softwareRenderer.Update(nullptr);
+
+		const auto startTime{ std::chrono::steady_clock::now() };
+		softwareRenderer.Render();
+		const auto endTime{ std::chrono::steady_clock::now() };
+
+		const double frameMilliseconds{ std::chrono::duration<double, std::milli>(endTime - startTime).count() };
+		totalMilliseconds += frameMilliseconds;
+
+		if (options.outputPrefix.empty() == false)
+		{
+			char frameSuffix[16]{};
+			std::snprintf(frameSuffix, sizeof(frameSuffix), "_%04d.", frameIdx);
+
+			const std::string fileName{ options.outputPrefix + frameSuffix + options.outputFormat };
+			if (softwareRenderer.SaveBufferToImage(fileName.c_str()) == false)
+			{
+				std::cout << "Failed to write " << fileName << std::endl;
+				return 1;
+			}
+		}
+
+		std::cout << "Frame " << frameIdx << ": " << frameMilliseconds << " ms";
+		if (options.targetFrameMs > 0.f) std::cout << " at scale " << softwareRenderer.GetResolutionScale();
+		std::cout << std::endl;
+	}
+
+	std::cout << "Average: " << totalMilliseconds / options.frameCount << " ms over " << options.frameCount << " frames at "
+		<< options.width << "x" << options.height << " on " << softwareRenderer.GetThreadCount() << " threads" << std::endl;
+	softwareRenderer.PrintShadingStatistics();
+
+#if defined(DAE_PROFILING)
+	if (options.traceFileName.empty() == false && Profiler::WriteChromeTrace(options.traceFileName.c_str()) == false)
+	{
+		std::cout << "Failed to write " << options.traceFileName << std::endl;
+		return 1;
+	}
+#endif
+
+	return 0;
+}
@@ -0,0 +1,181 @@
+#include "pch.h"
+#include "PresentQueue.h"
+
+#include <cstring>
+
+namespace dae
+{
+	PresentQueue::PresentQueue(SDL_Window* pWindow, int width, int height, uint32_t pixelFormat, uint32_t bufferCount)
+		: m_pWindow{ pWindow }
+	{
+		// The window owns its surface, headless gets one of its own
+		if (m_pWindow != nullptr) m_pFrontBuffer = SDL_GetWindowSurface(m_pWindow);
+		else m_pFrontBuffer = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, pixelFormat);
+
+		// Every buffer starts out free
+		for (uint32_t idx{}; idx < std::clamp(bufferCount, 1u, m_MaxBufferCount); ++idx)
+		{
+			m_pBuffers.push_back(SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, pixelFormat));
+		}
+		m_pFreeBuffers = m_pBuffers;
+
+		m_PresentThread = std::thread{ &PresentQueue::PresentLoop, this };
+	}
+	PresentQueue::~PresentQueue()
+	{
+		// Whatever got submitted still reaches the screen
+		Flush();
+
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_SubmitCondition.notify_one();
+		m_PresentThread.join();
+
+		for (SDL_Surface* pBuffer : m_pBuffers)
+		{
+			SDL_FreeSurface(pBuffer);
+		}
+		if (m_pWindow == nullptr) SDL_FreeSurface(m_pFrontBuffer);
+	}
+
+	SDL_Surface* PresentQueue::AcquireBuffer()
+	{
+		DAE_PROFILE_SCOPE("PresentQueue::AcquireBuffer");
+
+		std::unique_lock<std::mutex> lock{ m_Mutex };
+		m_PresentCondition.wait(lock, [this]() { return m_pFreeBuffers.empty() == false; });
+
+		SDL_Surface* pBuffer{ m_pFreeBuffers.back() };
+		m_pFreeBuffers.pop_back();
+		return pBuffer;
+	}
+
+	void PresentQueue::Submit(SDL_Surface* pBuffer)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			m_PendingFrames[(m_FirstPendingFrame + m_PendingFrameCount) % m_MaxBufferCount] = PendingFrame{ pBuffer, Clock::now() };
+			++m_PendingFrameCount;
+		}
+		m_SubmitCondition.notify_one();
+	}
+
+	void PresentQueue::UpdateWindow()
+	{
+		if (m_pWindow == nullptr) return;
+
+		// The present thread doesn't write the front buffer while the window reads it
+		std::lock_guard<std::mutex> frontBufferLock{ m_FrontBufferMutex };
+
+		Clock::time_point submitTime{};
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			if (m_HasCopiedFrame == false) return;
+
+			m_HasCopiedFrame = false;
+			submitTime = m_CopiedFrameSubmitTime;
+		}
+
+		DAE_PROFILE_SCOPE("PresentQueue::UpdateWindow");
+		SDL_UpdateWindowSurface(m_pWindow);
+
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_PresentLatencyMs = std::chrono::duration<double, std::milli>(Clock::now() - submitTime).count();
+	}
+
+	void PresentQueue::Flush()
+	{
+		{
+			std::unique_lock<std::mutex> lock{ m_Mutex };
+			m_PresentCondition.wait(lock, [this]() { return m_PendingFrameCount == 0 && m_IsPresenting == false; });
+		}
+
+		UpdateWindow();
+	}
+
+	double PresentQueue::GetPresentLatencyMs() const
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		return m_PresentLatencyMs;
+	}
+
+	void PresentQueue::CopyToFrontBuffer(const SDL_Surface* pBuffer)
+	{
+		// Ring buffers get the front buffer's format, which makes the copy a plain memcpy
+		const bool isSameLayout{ pBuffer->format->format == m_pFrontBuffer->format->format
+			&& pBuffer->w == m_pFrontBuffer->w && pBuffer->h == m_pFrontBuffer->h };
+		if (isSameLayout == false)
+		{
+			SDL_BlitSurface(const_cast<SDL_Surface*>(pBuffer), nullptr, m_pFrontBuffer, nullptr);
+			return;
+		}
+
+		SDL_LockSurface(m_pFrontBuffer);
+
+		// One copy for the whole frame, row by row only when the window pads its rows
+		const uint8_t* pSource{ static_cast<const uint8_t*>(pBuffer->pixels) };
+		uint8_t* pDestination{ static_cast<uint8_t*>(m_pFrontBuffer->pixels) };
+		if (pBuffer->pitch == m_pFrontBuffer->pitch)
+		{
+			std::memcpy(pDestination, pSource, static_cast<size_t>(pBuffer->pitch) * pBuffer->h);
+		}
+		else
+		{
+			const size_t rowSize{ static_cast<size_t>(pBuffer->w) * pBuffer->format->BytesPerPixel };
+			for (int row{}; row < pBuffer->h; ++row)
+			{
+				std::memcpy(pDestination + row * m_pFrontBuffer->pitch, pSource + row * pBuffer->pitch, rowSize);
+			}
+		}
+
+		SDL_UnlockSurface(m_pFrontBuffer);
+	}
+
+	void PresentQueue::PresentLoop()
+	{
+		DAE_PROFILE_THREAD_NAME("Present");
+
+		while (true)
+		{
+			// Wait for a frame
+			PendingFrame frame{};
+			{
+				std::unique_lock<std::mutex> lock{ m_Mutex };
+				m_SubmitCondition.wait(lock, [this]() { return m_IsStopping || m_PendingFrameCount > 0; });
+
+				if (m_PendingFrameCount == 0) return;
+				frame = m_PendingFrames[m_FirstPendingFrame];
+				m_FirstPendingFrame = (m_FirstPendingFrame + 1) % m_MaxBufferCount;
+				--m_PendingFrameCount;
+				m_IsPresenting = true;
+			}
+
+			// Only the copy happens on this thread, the renderer doesn't touch a submitted buffer
+			// The window gets updated by the main thread, headless the frame is done once copied
+			{
+				DAE_PROFILE_SCOPE("PresentQueue::Present");
+
+				std::lock_guard<std::mutex> frontBufferLock{ m_FrontBufferMutex };
+				CopyToFrontBuffer(frame.pBuffer);
+
+				std::lock_guard<std::mutex> lock{ m_Mutex };
+				if (m_pWindow != nullptr)
+				{
+					m_HasCopiedFrame = true;
+					m_CopiedFrameSubmitTime = frame.submitTime;
+				}
+				else m_PresentLatencyMs = std::chrono::duration<double, std::milli>(Clock::now() - frame.submitTime).count();
+			}
+
+			// Hand the buffer back, its pixels are in the front buffer now
+			{
+				std::lock_guard<std::mutex> lock{ m_Mutex };
+				m_pFreeBuffers.push_back(frame.pBuffer);
+				m_IsPresenting = false;
+			}
+			m_PresentCondition.notify_all();
+		}
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct SDL_Window;
+struct SDL_Surface;
+
+namespace dae
+{
+	// Software swap chain, a ring of back buffers presented by a thread of its own
+	// The renderer fills one buffer while the ones before it get copied to the window surface
+	// SDL only allows window calls on the main thread, so that one shows the copied frames through UpdateWindow
+	class PresentQueue final
+	{
+	public:
+		// Constructor and Destructor
+		// Without a window, frames get copied to an offscreen front buffer instead, so the ring still runs headless
+		PresentQueue(SDL_Window* pWindow, int width, int height, uint32_t pixelFormat, uint32_t bufferCount);
+		~PresentQueue();
+
+		// Rule of Five
+		PresentQueue(const PresentQueue&) = delete;
+		PresentQueue(PresentQueue&&) noexcept = delete;
+		PresentQueue& operator=(const PresentQueue&) = delete;
+		PresentQueue& operator=(PresentQueue&&) noexcept = delete;
+
+		// Public functions
+		// Blocks until a buffer is neither waiting for nor busy with presentation
+		SDL_Surface* AcquireBuffer();
+
+		// Frames get presented in submission order
+		void Submit(SDL_Surface* pBuffer);
+
+		// Main thread only, shows the last copied frame, waits while a copy is in progress
+		void UpdateWindow();
+
+		// Main thread only, blocks until every submitted frame is on screen
+		void Flush();
+
+		uint32_t GetBufferCount() const { return static_cast<uint32_t>(m_pBuffers.size()); }
+
+		// Submit to on screen, of the last presented frame
+		double GetPresentLatencyMs() const;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct PendingFrame
+		{
+			SDL_Surface* pBuffer{ nullptr };
+			Clock::time_point submitTime{};
+		};
+
+		static constexpr uint32_t m_MaxBufferCount{ 3 };
+
+		SDL_Window* m_pWindow{ nullptr };
+		SDL_Surface* m_pFrontBuffer{ nullptr };
+
+		std::vector<SDL_Surface*> m_pBuffers{};
+		std::vector<SDL_Surface*> m_pFreeBuffers{};
+
+		// Fixed ring, every pending frame holds a buffer so it never overflows, and submitting never allocates
+		std::array<PendingFrame, m_MaxBufferCount> m_PendingFrames{};
+		uint32_t m_FirstPendingFrame{};
+		uint32_t m_PendingFrameCount{};
+
+		std::thread m_PresentThread{};
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_SubmitCondition{};
+		std::condition_variable m_PresentCondition{};
+
+		// Held while the front buffer gets written or shown
+		std::mutex m_FrontBufferMutex{};
+
+		bool m_IsPresenting{ false };
+		bool m_IsStopping{ false };
+
+		// Copied to the front buffer, but not yet shown in the window
+		bool m_HasCopiedFrame{ false };
+		Clock::time_point m_CopiedFrameSubmitTime{};
+		double m_PresentLatencyMs{};
+
+		// Member Functions
+		void PresentLoop();
+		void CopyToFrontBuffer(const SDL_Surface* pBuffer);
+	};
+}
@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+namespace dae
+{
+	namespace
+	{
+		struct TraceEvent
+		{
+			const char* pName{};
+			int64_t startTime{};
+			int64_t endTime{};
+		};
+
+		// One per thread that ever recorded, outlives the thread so its lane stays in the trace
+		struct ThreadTrace
+		{
+			uint32_t threadId{};
+			std::string name{};
+
+			// Only contended while a trace gets written
+			std::mutex mutex{};
+			std::vector<TraceEvent> events{};
+		};
+
+		const std::chrono::steady_clock::time_point g_StartTime{ std::chrono::steady_clock::now() };
+
+		std::mutex g_ThreadTracesMutex{};
+		std::vector<std::unique_ptr<ThreadTrace>> g_pThreadTraces{};
+
+		thread_local ThreadTrace* t_pThreadTrace{ nullptr };
+
+		ThreadTrace& GetThreadTrace()
+		{
+			if (t_pThreadTrace == nullptr)
+			{
+				std::lock_guard<std::mutex> lock{ g_ThreadTracesMutex };
+
+				auto pThreadTrace{ std::make_unique<ThreadTrace>() };
+				pThreadTrace->threadId = static_cast<uint32_t>(g_pThreadTraces.size());
+				pThreadTrace->name = "Thread " + std::to_string(pThreadTrace->threadId);
+
+				t_pThreadTrace = pThreadTrace.get();
+				g_pThreadTraces.push_back(std::move(pThreadTrace));
+			}
+
+			return *t_pThreadTrace;
+		}
+
+		std::string EscapeJson(const std::string& text)
+		{
+			std::string escapedText{};
+			for (char character : text)
+			{
+				if (character == '"' || character == '\\') escapedText += '\\';
+				escapedText += character;
+			}
+			return escapedText;
+		}
+	}
+
+	void Profiler::SetRecording(bool isRecording)
+	{
+		m_IsRecording.store(isRecording, std::memory_order_relaxed);
+	}
+
+	void Profiler::SetThreadName(const std::string& name)
+	{
+		ThreadTrace& threadTrace{ GetThreadTrace() };
+
+		std::lock_guard<std::mutex> lock{ threadTrace.mutex };
+		threadTrace.name = name;
+	}
+
+	bool Profiler::WriteChromeTrace(const char* fileName)
+	{
+		FILE* pFile{ std::fopen(fileName, "w") };
+		if (pFile == nullptr) return false;
+
+		std::fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+		// Complete events, timestamps in microseconds
+		bool isFirstEvent{ true };
+		std::lock_guard<std::mutex> tracesLock{ g_ThreadTracesMutex };
+		for (const auto& pThreadTrace : g_pThreadTraces)
+		{
+			std::lock_guard<std::mutex> lock{ pThreadTrace->mutex };
+
+			std::fprintf(pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+				isFirstEvent ? "" : ",\n", pThreadTrace->threadId, EscapeJson(pThreadTrace->name).c_str());
+			isFirstEvent = false;
+
+			for (const TraceEvent& event : pThreadTrace->events)
+			{
+				std::fprintf(pFile, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					event.pName, pThreadTrace->threadId, event.startTime / 1000.0, (event.endTime - event.startTime) / 1000.0);
+			}
+			pThreadTrace->events.clear();
+		}
+
+		std::fprintf(pFile, "\n]}\n");
+		return std::fclose(pFile) == 0;
+	}
+
+	int64_t Profiler::GetTime()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_StartTime).count();
+	}
+
+	void Profiler::AddEvent(const char* pName, int64_t startTime, int64_t endTime)
+	{
+		ThreadTrace& threadTrace{ GetThreadTrace() };
+
+		std::lock_guard<std::mutex> lock{ threadTrace.mutex };
+		threadTrace.events.push_back(TraceEvent{ pName, startTime, endTime });
+	}
+}
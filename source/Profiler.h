@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Scoped timers, written out as a Chrome trace for chrome://tracing or ui.perfetto.dev
+// Only built with DAE_PROFILING, otherwise the macros are empty and their arguments never evaluated
+#if defined(DAE_PROFILING)
+#define DAE_PROFILE_CONCAT_INNER(a, b) a##b
+#define DAE_PROFILE_CONCAT(a, b) DAE_PROFILE_CONCAT_INNER(a, b)
+#define DAE_PROFILE_SCOPE(name) const dae::ProfileScope DAE_PROFILE_CONCAT(profileScope, __LINE__){ name }
+#define DAE_PROFILE_THREAD_NAME(name) dae::Profiler::SetThreadName(name)
+#else
+#define DAE_PROFILE_SCOPE(name) ((void)0)
+#define DAE_PROFILE_THREAD_NAME(name) ((void)0)
+#endif
+
+namespace dae
+{
+	class Profiler final
+	{
+	public:
+		Profiler() = delete;
+
+		// Scopes are only recorded while recording, it starts out on so startup ends up in the first trace
+		static void SetRecording(bool isRecording);
+		static bool IsRecording() { return m_IsRecording.load(std::memory_order_relaxed); }
+
+		// Lane name of the calling thread
+		static void SetThreadName(const std::string& name);
+
+		// Writes everything recorded so far and starts over
+		static bool WriteChromeTrace(const char* fileName);
+
+		// Nanoseconds since startup
+		static int64_t GetTime();
+		static void AddEvent(const char* pName, int64_t startTime, int64_t endTime);
+
+	private:
+		static inline std::atomic<bool> m_IsRecording{ true };
+	};
+
+	class ProfileScope final
+	{
+	public:
+		// Only the pointer is kept, so pName has to be a string literal
+		explicit ProfileScope(const char* pName)
+			: m_pName{ pName }
+			, m_StartTime{ Profiler::IsRecording() ? Profiler::GetTime() : -1 }
+		{
+		}
+		~ProfileScope()
+		{
+			if (m_StartTime >= 0) Profiler::AddEvent(m_pName, m_StartTime, Profiler::GetTime());
+		}
+
+		// Rule of Five
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope(ProfileScope&&) noexcept = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+		ProfileScope& operator=(ProfileScope&&) noexcept = delete;
+
+	private:
+		const char* m_pName{};
+		int64_t m_StartTime{};
+	};
+}
@@ -14,11 +14,18 @@ namespace dae
 	Renderer::Renderer(SDL_Window* pWindow)
 	{
 		// Initialize variables
-		if (Initialize(pWindow) == false)
 		{
-			std::cout << "Failed to initialize renderers" << std::endl;
+			DAE_PROFILE_SCOPE("Renderer::Initialize");
+
+			if (Initialize(pWindow) == false)
+			{
+				std::cout << "Failed to initialize renderers" << std::endl;
+			}
+			else m_InitializingSucceeded = true;
 		}
-		else m_InitializingSucceeded = true;
+
+		// Startup is recorded, frames only on request
+		Profiler::SetRecording(false);
 
 		PrintInfo();
 	}
@@ -32,6 +39,8 @@ namespace dae
 		// When failed initialization, return
 		if (m_InitializingSucceeded == false) return;
 
+		DAE_PROFILE_SCOPE("Renderer::Update");
+
 		// Update camera
 		m_pCamera->Update(pTimer);
 
@@ -49,6 +58,8 @@ namespace dae
 		// When failed initialization, return
 		if (m_InitializingSucceeded == false) return;
 
+		DAE_PROFILE_SCOPE("Renderer::Render");
+
 		if (m_ShowHardware)
 		{
 			// Render directXRenderer
@@ -67,6 +78,9 @@ namespace dae
 		
 		if (m_ShowHardware)
 		{
+			// Queued software frames would otherwise reach the window after the swap chain took over
+			m_pSoftwareRenderer->FlushPresent();
+
 			std::cout << "Now using the hardware renderer" << std::endl;
 		}
 		else
@@ -147,6 +161,74 @@ namespace dae
 	{
 		if (m_ShowHardware == false) m_pSoftwareRenderer->ToggleBoundingBox();
 	}
+	void Renderer::ToggleVisibilityBuffer()
+	{
+		if (m_ShowHardware == false) m_pSoftwareRenderer->ToggleVisibilityBuffer();
+	}
+	void Renderer::ToggleSrgbOutput()
+	{
+		if (m_ShowHardware == false) m_pSoftwareRenderer->ToggleSrgbOutput();
+	}
+	void Renderer::ToggleDepthFormat()
+	{
+		if (m_ShowHardware == false) m_pSoftwareRenderer->ToggleDepthFormat();
+	}
+	void Renderer::ToggleDepthCompression()
+	{
+		if (m_ShowHardware == false) m_pSoftwareRenderer->ToggleDepthCompression();
+	}
+	void Renderer::ToggleMsaa()
+	{
+		if (m_ShowHardware == false) m_pSoftwareRenderer->ToggleMsaa();
+	}
+	void Renderer::ToggleDynamicResolution()
+	{
+		if (m_ShowHardware == false) m_pSoftwareRenderer->ToggleDynamicResolution();
+	}
+	void Renderer::ToggleShadingRate()
+	{
+		if (m_ShowHardware == false) m_pSoftwareRenderer->ToggleShadingRate();
+	}
+	void Renderer::TogglePresentBuffers()
+	{
+		if (m_ShowHardware == false) m_pSoftwareRenderer->TogglePresentBuffers();
+	}
+	void Renderer::ToggleHeatmap()
+	{
+		if (m_ShowHardware == false) m_pSoftwareRenderer->ToggleHeatmap();
+	}
+	void Renderer::ExportSoftwareFrame() const
+	{
+		if (m_ShowHardware == false) m_pSoftwareRenderer->ExportFrame();
+	}
+	void Renderer::ToggleTraceCapture()
+	{
+#if defined(DAE_PROFILING)
+		if (Profiler::IsRecording() == false)
+		{
+			Profiler::SetRecording(true);
+			std::cout << "Trace capture started" << std::endl;
+			return;
+		}
+
+		// First trace also holds startup
+		Profiler::SetRecording(false);
+		if (Profiler::WriteChromeTrace("Rasterizer_Trace.json"))
+		{
+			std::cout << "Trace written to Rasterizer_Trace.json" << std::endl;
+		}
+		else std::cout << "Failed to write Rasterizer_Trace.json" << std::endl;
+#else
+		std::cout << "Trace capture needs a build with DAE_PROFILING defined" << std::endl;
+#endif
+	}
+
+	void Renderer::PrintStatistics() const
+	{
+		if (m_InitializingSucceeded == false) return;
+
+		if (m_ShowHardware == false) m_pSoftwareRenderer->PrintShadingStatistics();
+	}
 
 	bool Renderer::Initialize(SDL_Window* pWindow)
 	{
@@ -282,6 +364,7 @@ namespace dae
 		std::cout << '\t' << "[F9]" << '\t' << "Cycle CullMode (BACK/FRONT/NONE)" << std::endl;
 		std::cout << '\t' << "[F10]" << '\t' << "Toggle Uniform ClearColor (ON/OFF)" << std::endl;
 		std::cout << '\t' << "[F11]" << '\t' << "Toggle Print FPS (ON/OFF)" << std::endl;
+		std::cout << '\t' << "[5]" << '\t' << "Start/Stop Trace Capture (Rasterizer_Trace.json)" << std::endl;
 		std::cout << std::endl;
 
 		std::cout << "Key Binding: Hardware" << std::endl;
@@ -294,6 +377,16 @@ namespace dae
 		std::cout << '\t' << "[F6]" << '\t' << "Toggle NormalMap (ON/OFF)" << std::endl;
 		std::cout << '\t' << "[F7]" << '\t' << "Toggle DepthBuffer Visualization (ON/OFF)" << std::endl;
 		std::cout << '\t' << "[F8]" << '\t' << "Toggle BoundingBox Visualization (ON/OFF)" << std::endl;
+		std::cout << '\t' << "[1]" << '\t' << "Toggle Visibility Buffer Shading (ON/OFF)" << std::endl;
+		std::cout << '\t' << "[2]" << '\t' << "Toggle sRGB Output (ON/OFF)" << std::endl;
+		std::cout << '\t' << "[3]" << '\t' << "Cycle Depth Format (FLOAT/REVERSED FLOAT/UNORM24/UNORM16)" << std::endl;
+		std::cout << '\t' << "[4]" << '\t' << "Toggle Depth Compression (ON/OFF)" << std::endl;
+		std::cout << '\t' << "[6]" << '\t' << "Toggle 4x MSAA (ON/OFF)" << std::endl;
+		std::cout << '\t' << "[7]" << '\t' << "Toggle Dynamic Resolution (ON/OFF)" << std::endl;
+		std::cout << '\t' << "[8]" << '\t' << "Cycle Shading Rate (FULL/ADAPTIVE/2X2)" << std::endl;
+		std::cout << '\t' << "[9]" << '\t' << "Cycle Present Back Buffers (1/2/3)" << std::endl;
+		std::cout << '\t' << "[0]" << '\t' << "Cycle Heatmap (OFF/OVERDRAW/DEPTH FAILURES/TILE COST)" << std::endl;
+		std::cout << '\t' << "[X]" << '\t' << "Export Frame (Rasterizer_<heatmap>.bmp)" << std::endl;
 		std::cout << std::endl << std::endl << std::endl << std::endl;
 	}
 
@@ -42,6 +42,20 @@ namespace dae
 		void ToggleNormalMap();
 		void ToggleDepthBuffer();
 		void ToggleBoundingBox();
+		void ToggleVisibilityBuffer();
+		void ToggleSrgbOutput();
+		void ToggleDepthFormat();
+		void ToggleDepthCompression();
+		void ToggleMsaa();
+		void ToggleDynamicResolution();
+		void ToggleShadingRate();
+		void TogglePresentBuffers();
+		void ToggleHeatmap();
+		void ExportSoftwareFrame() const;
+
+		void ToggleTraceCapture();
+
+		void PrintStatistics() const;
 
 	private:
 		// Member Variables
@@ -10,10 +10,19 @@
 #include "Texture.h"
 #include "Utils.h"
 #include "BRDFs.h"
+#include "ThreadPool.h"
+#include "FrameArena.h"
+#include "PresentQueue.h"
 
 // Printing
 #include <iostream>
 
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
 using namespace dae;
 
 SoftwareRenderer::SoftwareRenderer(SDL_Window* pWindow, int windowWidth, int windowHeight,
@@ -23,8 +32,8 @@ SoftwareRenderer::SoftwareRenderer(SDL_Window* pWindow, int windowWidth, int win
 									const Matrix* pWorldMatrix, bool* pUseClearColorBackground, CullingMode* pCurrentCullingMode)
 	// Window
 	: m_pWindow(pWindow)
-	, m_Width{ windowWidth }
-	, m_Height{ windowHeight }
+	, m_WindowWidth{ windowWidth }
+	, m_WindowHeight{ windowHeight }
 	// Textures
 	, m_pDiffuseTexture{ pDiffuseTexture }
 	, m_pNormalTexture{ pNormalTexture }
@@ -37,24 +46,122 @@ SoftwareRenderer::SoftwareRenderer(SDL_Window* pWindow, int windowWidth, int win
 	, m_pUseClearColorBackground{ pUseClearColorBackground }
 	, m_pCurrentCullingMode{ pCurrentCullingMode }
 {
-	//Create Buffers
-	m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-	m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
+	//Create Buffers, without a window the frame stays in the backBuffer
+	// A window surface with 32-bit pixels and 8-bit channels gets resolved into directly, the color resolve packs any such format
+	if (m_pWindow != nullptr) m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
+	if (m_pFrontBuffer != nullptr && m_pFrontBuffer->w == m_WindowWidth && m_pFrontBuffer->h == m_WindowHeight
+		&& m_pFrontBuffer->format->BytesPerPixel == 4 && m_pFrontBuffer->format->Rloss == 0 && m_pFrontBuffer->format->Gloss == 0 && m_pFrontBuffer->format->Bloss == 0)
+	{
+		m_pSyncBackBuffer = m_pFrontBuffer;
+	}
+	else
+	{
+		m_pSyncBackBuffer = SDL_CreateRGBSurface(0, m_WindowWidth, m_WindowHeight, 32, 0, 0, 0, 0);
+	}
+	m_pBackBuffer = m_pSyncBackBuffer;
 	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
 
 	// Create BufferArray and initialize all with maxFloat value
-	m_pDepthBufferPixels = new float[m_Width * m_Height];
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	// Sized for the widest format, tiles get cleared before their first use
+	m_pDepthBufferPixels = new std::byte[m_WindowWidth * m_WindowHeight * sizeof(float)];
+
+	// Linear color, one plane per channel
+	m_pColorBufferPixels = new float[m_WindowWidth * m_WindowHeight * 3];
+
+	// Linear to sRGB, indexed by the clamped channel value
+	m_SrgbLut.resize(m_SrgbLutSize);
+	for (int idx{}; idx < m_SrgbLutSize; ++idx)
+	{
+		const float linearValue{ static_cast<float>(idx) / (m_SrgbLutSize - 1) };
+		const float srgbValue{ linearValue <= 0.0031308f ? linearValue * 12.92f : 1.055f * std::pow(linearValue, 1.f / 2.4f) - 0.055f };
+		m_SrgbLut[idx] = static_cast<uint32_t>(srgbValue * 255.f + 0.5f);
+	}
 
 	// Define mesh
 	std::vector<Mesh> meshes_world{};
 	meshes_world.push_back(Mesh{ vertices,indices,PrimitiveTopology::TriangleList });
 	m_Meshes = meshes_world;
+
+	// Face planes for culling before the vertex transform
+	for (const auto& mesh : m_Meshes)
+	{
+		m_MeshFacePlanes.push_back(CreateFacePlanes(mesh));
+	}
+
+	// Tiles, HiZ and the guard band, starting out at the window size
+	SetRenderSize(m_WindowWidth, m_WindowHeight);
+
+	// Create workers, one per hardware thread by default
+	SetThreadCount(std::thread::hardware_concurrency());
+
+	// Grows to the peak of the first frames by itself
+	m_pFrameArena = new FrameArena{};
+
+	// Resolving straight into the window surface needs no copy, other windows get double buffered
+	// Headless frames stay in the backBuffer
+	if (m_pWindow != nullptr && m_pSyncBackBuffer != m_pFrontBuffer) SetPresentBufferCount(2);
 }
 
 SoftwareRenderer::~SoftwareRenderer()
 {
+	delete m_pPresentQueue;
+	delete m_pFrameArena;
+	delete m_pThreadPool;
+	delete[] m_pSampleColorPixels;
+	delete[] m_pSampleDepthPixels;
+	delete[] m_pColorBufferPixels;
 	delete[] m_pDepthBufferPixels;
+	SDL_FreeSurface(m_pScaledBuffer);
+	if (m_pSyncBackBuffer != m_pFrontBuffer) SDL_FreeSurface(m_pSyncBackBuffer);
+}
+
+void SoftwareRenderer::SetRenderSize(int width, int height)
+{
+	if (width == m_Width && height == m_Height) return;
+
+	m_Width = width;
+	m_Height = height;
+
+	// Split screen into tiles, every tile gets its own bin of triangles
+	m_TileCountX = (m_Width + m_TileSize - 1) / m_TileSize;
+	m_TileCountY = (m_Height + m_TileSize - 1) / m_TileSize;
+	m_TileBins.resize(m_TileCountX * m_TileCountY);
+	m_TileStatistics.resize(m_TileCountX * m_TileCountY);
+
+	// HiZ, blocks never straddle two tiles
+	m_HiZBlockCountX = (m_Width + m_HiZBlockSize - 1) / m_HiZBlockSize;
+	m_HiZBlockCountY = (m_Height + m_HiZBlockSize - 1) / m_HiZBlockSize;
+	m_HiZBlocks.resize(m_HiZBlockCountX * m_HiZBlockCountY);
+	m_HiZTileMaxDepths.resize(m_TileCountX * m_TileCountY);
+	m_HiZTileDirty.resize(m_TileCountX * m_TileCountY);
+
+	// Rate blocks don't straddle tiles either, they start out at full rate
+	m_ShadingRateBlockCountX = (m_Width + m_ShadingRateBlockSize - 1) / m_ShadingRateBlockSize;
+	m_ShadingRateBlockCountY = (m_Height + m_ShadingRateBlockSize - 1) / m_ShadingRateBlockSize;
+	m_ShadingRates.assign(m_ShadingRateBlockCountX * m_ShadingRateBlockCountY, uint8_t{});
+
+	m_TileCleared.resize(m_TileCountX * m_TileCountY);
+	m_TileDepthStates.resize(m_TileCountX * m_TileCountY);
+	m_TilePlanarTriangles.resize(m_TileCountX * m_TileCountY);
+
+	// Guard band in NDC units, a fixed amount of pixels past every screen side
+	m_GuardBandX = 1.f + 2.f * m_GuardBandPixels / m_Width;
+	m_GuardBandY = 1.f + 2.f * m_GuardBandPixels / m_Height;
+
+	// Pixel centers of the window mapped onto the render target, clamped at the borders
+	m_UpscaleSourceX0.resize(m_WindowWidth);
+	m_UpscaleSourceX1.resize(m_WindowWidth);
+	m_UpscaleWeightsX.resize(m_WindowWidth * 4);
+	for (int px{}; px < m_WindowWidth; ++px)
+	{
+		const float sourceX{ std::max((px + 0.5f) * m_Width / m_WindowWidth - 0.5f, 0.f) };
+		const int firstSourceX{ std::min(static_cast<int>(sourceX), m_Width - 1) };
+		const uint16_t weight{ static_cast<uint16_t>((sourceX - static_cast<float>(firstSourceX)) * 256.f) };
+
+		m_UpscaleSourceX0[px] = firstSourceX;
+		m_UpscaleSourceX1[px] = std::min(firstSourceX + 1, m_Width - 1);
+		std::fill(m_UpscaleWeightsX.begin() + px * 4, m_UpscaleWeightsX.begin() + px * 4 + 4, std::min(weight, uint16_t{ 255 }));
+	}
 }
 
 void SoftwareRenderer::Update(const Timer* pTimer)
@@ -68,6 +175,38 @@ void SoftwareRenderer::Update(const Timer* pTimer)
 
 void SoftwareRenderer::Render()
 {
+	DAE_PROFILE_SCOPE("SoftwareRenderer::Render");
+
+	// Wall time per stage, for benchmarks
+	using Clock = std::chrono::steady_clock;
+	const auto getMilliseconds = [](Clock::time_point startTime, Clock::time_point endTime)
+		{
+			return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+		};
+
+	m_FrameTimings = FrameTimings{};
+	const Clock::time_point frameStartTime{ Clock::now() };
+
+	// Next buffer of the ring, waits while all of them are still queued or being presented
+	Clock::time_point acquireEndTime{ frameStartTime };
+	if (m_pPresentQueue != nullptr)
+	{
+		m_pBackBuffer = m_pPresentQueue->AcquireBuffer();
+		m_pBackBufferPixels = static_cast<uint32_t*>(m_pBackBuffer->pixels);
+		acquireEndTime = Clock::now();
+	}
+
+	// Internal resolution of this frame, anything below the window size gets upscaled at the end
+	SetRenderSize(std::max(static_cast<int>(std::lround(m_WindowWidth * m_ResolutionScale)), 1),
+		std::max(static_cast<int>(std::lround(m_WindowHeight * m_ResolutionScale)), 1));
+
+	const bool isUpscaled{ m_Width != m_WindowWidth || m_Height != m_WindowHeight };
+	if (isUpscaled && m_pScaledBuffer == nullptr)
+	{
+		m_pScaledBuffer = SDL_CreateRGBSurfaceWithFormat(0, m_WindowWidth, m_WindowHeight, 32, m_pBackBuffer->format->format);
+	}
+	m_pRenderTarget = isUpscaled ? m_pScaledBuffer : m_pBackBuffer;
+
 	//@START
 	//Lock BackBuffer
 	SDL_LockSurface(m_pBackBuffer);
@@ -78,449 +217,3172 @@ void SoftwareRenderer::Render()
 	Vector3 backgroundColor{ 0.39f, 0.39f, 0.39f };
 	if (*m_pUseClearColorBackground) backgroundColor = Vector3{ 0.1f, 0.1f, 0.1f };
 
-	SDL_FillRect(m_pBackBuffer, NULL, SDL_MapRGB(m_pBackBuffer->format,
-		static_cast<Uint8>(backgroundColor.x * 255),
-		static_cast<Uint8>(backgroundColor.y * 255),
-		static_cast<Uint8>(backgroundColor.z * 255)));
+	// Clears are lazy, a tile only clears its color and depth once something gets drawn into it
+	m_ClearColor = ColorRGB{ backgroundColor.x, backgroundColor.y, backgroundColor.z };
+	m_ClearPixel = PackColor(m_ClearColor);
+	std::fill(m_TileCleared.begin(), m_TileCleared.end(), static_cast<uint8_t>(false));
+
+	// Unorm formats can't store FLT_MAX, they clear to their far plane instead
+	switch (m_DepthFormat)
+	{
+	case DepthFormat::Unorm24:
+		m_DepthClearValue = GetDepthScale<DepthFormat::Unorm24>();
+		break;
+	case DepthFormat::Unorm16:
+		m_DepthClearValue = GetDepthScale<DepthFormat::Unorm16>();
+		break;
+	default:
+		m_DepthClearValue = FLT_MAX;
+		break;
+	}
+
+	// Reset HiZ tiles, blocks get reset together with their tile
+	std::fill(m_HiZTileMaxDepths.begin(), m_HiZTileMaxDepths.end(), m_DepthClearValue);
+	std::fill(m_HiZTileDirty.begin(), m_HiZTileDirty.end(), static_cast<uint8_t>(false));
+
+	// Visibility buffer starts out cleared, the resolve pass clears every pixel it reads
+	// Multisampled, it holds an id per sample
+	m_UseDeferredShading = m_UseVisibilityBuffer || m_ShadingRateMode != ShadingRateMode::Full;
+	const size_t visibilityIdCount{ static_cast<size_t>(m_Width) * m_Height * (m_UseMsaa ? m_SampleCount : 1) };
+	if (m_UseDeferredShading && m_VisibilityTriangleIds.size() < visibilityIdCount)
+	{
+		m_VisibilityTriangleIds.resize(visibilityIdCount, m_InvalidTriangleIdx);
+	}
+
+	// Per-pixel counts for the heatmaps, the pixel loops add to them while rasterizing
+	m_IsCountingFragments = m_HeatmapMode == HeatmapMode::Overdraw || m_HeatmapMode == HeatmapMode::DepthFailures;
+	if (m_IsCountingFragments) m_HeatmapCounts.assign(static_cast<size_t>(m_Width) * m_Height, uint16_t{});
+
+	m_CameraOrigin = m_pCamera->GetOrigin();
+
+	// Last frame's transient data is gone, containers keep their capacity for this one
+	m_pFrameArena->Reset();
+	m_Triangles.clear();
+	std::fill(m_TileBins.begin(), m_TileBins.end(), TileBin{});
 
-	// Refill depthBuffer
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	Clock::time_point stageStartTime{ Clock::now() };
+	m_FrameTimings.clearMs = getMilliseconds(acquireEndTime, stageStartTime);
 
 	// For every mesh
 	for (size_t idx{}; idx < m_Meshes.size(); ++idx)
 	{
-		const Mesh currentMesh{ m_Meshes[idx] };
-		const bool usingStripTopology{ currentMesh.primitiveTopology == PrimitiveTopology::TriangleStrip };
+		const Mesh& currentMesh{ m_Meshes[idx] };
 
 		//////////////////////
 		// -- PROJECTION -- //
 		//////////////////////
 
-		// Transform model-space vertices to NDC-space vertices
-		std::vector<VS_OUPUT> vertexOut{};
+		// Transform model-space vertices to clip-space vertices
 		const Matrix worldMatrix{ m_Meshes[idx].worldMatrix };
 
-		VertexTransformationFunction(currentMesh.vertices, vertexOut, worldMatrix);
+		// Drop triangles facing the wrong way in object space, their vertices don't need a transform
+		CullTriangles(currentMesh, m_MeshFacePlanes[idx], worldMatrix);
+		VertexTransformationFunction(currentMesh.vertices, m_VerticesOut, worldMatrix);
 
+		const Clock::time_point transformEndTime{ Clock::now() };
+		m_FrameTimings.transformMs += getMilliseconds(stageStartTime, transformEndTime);
+		stageStartTime = transformEndTime;
 
-		/////////////////////////////
-		// -- PRIMITIVE TOPOLGY -- //
-		/////////////////////////////
+		/////////////////
+		// -- SETUP -- //
+		/////////////////
 
-		// For-loop counting depends on primitiveTopolgy
-		size_t idxAddition{ 3 };
-		size_t indicesSizeLimit{ 0 };
-		if (usingStripTopology)
-		{
-			idxAddition = 1;
-			indicesSizeLimit = 2;
-		}
+		// Sort triangles into the screen tiles they touch
+		SetupTriangles(currentMesh);
 
+		const Clock::time_point setupEndTime{ Clock::now() };
+		m_FrameTimings.setupMs += getMilliseconds(stageStartTime, setupEndTime);
+		stageStartTime = setupEndTime;
+	}
 
-		// For every triangle
-		for (size_t idx{}; idx < currentMesh.indices.size() - indicesSizeLimit; idx += idxAddition)
-		{
-			// VertexIndices
-			const int firstIndex{ (int)currentMesh.indices[idx] };
-			int secondIndex{ (int)currentMesh.indices[idx + 1] };
-			int thirdIndex{ (int)currentMesh.indices[idx + 2] };
 
-			// Swap second and third index with triangleStrip
-			const bool triangleIsOdd{ idx % 2 == 1 };
-			if (usingStripTopology && triangleIsOdd)
-			{
-				std::swap(secondIndex, thirdIndex);
-			}
+	/////////////////////////
+	// -- RASTERIZATION -- //
+	/////////////////////////
 
+	// Every tile only touches its own pixels, so tiles can be rasterized independently
+	// Triangles keep their submission order inside a bin, which keeps the output identical to a serial pass
+	// The tile cost heatmap times every tile's raster and deferred shading work
+	const uint32_t tileCount{ static_cast<uint32_t>(m_TileCountX * m_TileCountY) };
+	const bool isMeasuringTiles{ m_HeatmapMode == HeatmapMode::TileCost };
+	if (isMeasuringTiles) m_TileCostNanoseconds.assign(tileCount, uint64_t{});
 
-			// Normal Vertices
-			std::vector<VS_OUPUT> normalVertices{};
-			normalVertices.push_back(vertexOut[firstIndex]);
-			normalVertices.push_back(vertexOut[secondIndex]);
-			normalVertices.push_back(vertexOut[thirdIndex]);
+	const auto addTileCost = [this](uint32_t tileIdx, Clock::time_point startTime)
+		{
+			m_TileCostNanoseconds[tileIdx] += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime).count();
+		};
 
+	m_pThreadPool->ParallelFor(tileCount, [&](uint32_t tileIdx, uint32_t)
+		{
+			const Clock::time_point tileStartTime{ isMeasuringTiles ? Clock::now() : Clock::time_point{} };
+			RasterizeTile(tileIdx);
+			if (isMeasuringTiles) addTileCost(tileIdx, tileStartTime);
+		});
 
-			////////////////////////
-			// -- Optimization -- //
-			////////////////////////
+	const Clock::time_point rasterEndTime{ Clock::now() };
+	m_FrameTimings.rasterMs = getMilliseconds(stageStartTime, rasterEndTime);
 
-			// Check if not insideFrustum
-			bool isInsideFrustum{ true };
-			for (const auto& vertex : normalVertices)
+	// Visibility buffer holds one fragment per pixel, shade them all in one go
+	if (m_UseDeferredShading)
+	{
+		m_pThreadPool->ParallelFor(tileCount, [&](uint32_t tileIdx, uint32_t)
 			{
-				const bool xInsideFrustum{ -1.f <= vertex.Position.x && vertex.Position.x <= 1.f };
-				const bool yInsideFrustum{ -1.f <= vertex.Position.y && vertex.Position.y <= 1.f };
-				const bool zInsideFrustum{ 0.f <= vertex.Position.z && vertex.Position.z <= 1.f };
+				const Clock::time_point tileStartTime{ isMeasuringTiles ? Clock::now() : Clock::time_point{} };
+				ResolveTile(tileIdx);
+				if (isMeasuringTiles) addTileCost(tileIdx, tileStartTime);
+			});
+	}
 
-				const bool currentInsideFrustum{ xInsideFrustum && yInsideFrustum && zInsideFrustum };
-				if (!currentInsideFrustum)
-				{
-					isInsideFrustum = false;
-					break;
-				}
-			}
+	const Clock::time_point shadeEndTime{ Clock::now() };
+	m_FrameTimings.deferredShadeMs = getMilliseconds(rasterEndTime, shadeEndTime);
+
+	// Float colors to the backBuffer's pixel format, untouched tiles get the clear color
+	// A heatmap replaces the resolved colors, the resolve still runs so adaptive shading rates stay current
+	const uint64_t maxTileCost{ isMeasuringTiles ? *std::max_element(m_TileCostNanoseconds.begin(), m_TileCostNanoseconds.end()) : 0 };
+	m_pThreadPool->ParallelFor(tileCount, [this, maxTileCost](uint32_t tileIdx, uint32_t)
+		{
+			ResolveColorTile(tileIdx);
+			if (m_HeatmapMode != HeatmapMode::Off) WriteHeatmapTile(tileIdx, maxTileCost);
+		});
+
+	const Clock::time_point resolveEndTime{ Clock::now() };
+	m_FrameTimings.resolveMs = getMilliseconds(shadeEndTime, resolveEndTime);
 
-			// Else, don't show
-			if (!isInsideFrustum)
+	// Filter the lower internal resolution up to the window, in bands of rows
+	if (isUpscaled)
+	{
+		const uint32_t jobCount{ static_cast<uint32_t>((m_WindowHeight + m_UpscaleRowsPerJob - 1) / m_UpscaleRowsPerJob) };
+		m_pThreadPool->ParallelFor(jobCount, [this](uint32_t jobIdx, uint32_t)
 			{
-				continue;
-			}
+				const int firstRow{ static_cast<int>(jobIdx) * m_UpscaleRowsPerJob };
+				UpscaleRows(firstRow, std::min(firstRow + m_UpscaleRowsPerJob, m_WindowHeight));
+			});
+	}
 
+	const Clock::time_point upscaleEndTime{ Clock::now() };
+	m_FrameTimings.upscaleMs = getMilliseconds(resolveEndTime, upscaleEndTime);
 
-			/////////////////////////
-			// -- RASTERIZATION -- //
-			/////////////////////////
+	// Gather statistics
+	m_ShadingStatistics = ShadingStatistics{};
+	for (const auto& tileStatistics : m_TileStatistics)
+	{
+		m_ShadingStatistics.depthPassedFragments += tileStatistics.depthPassedFragments;
+		m_ShadingStatistics.shadedPixels += tileStatistics.shadedPixels;
+	}
 
+	//@END
+	//Update SDL Surface
+	SDL_UnlockSurface(m_pBackBuffer);
 
-			// NDC-space to raster-space
-			std::vector<VS_OUPUT> rasterVertices{};
-			for (size_t idx{}; idx < normalVertices.size(); ++idx)
-			{
-				VS_OUPUT newVertex{ normalVertices[idx] };
-				newVertex.Position.x = ((newVertex.Position.x + 1) / 2) * m_Width;
-				newVertex.Position.y = ((1 - newVertex.Position.y) / 2) * m_Height;
+	// The present thread copies it to the window surface while the next frame renders
+	// Showing the surface is a main thread call, so the frame it copied last time gets shown here
+	// Headless without a ring, whoever owns the renderer reads the backBuffer
+	if (m_pPresentQueue != nullptr)
+	{
+		m_pPresentQueue->UpdateWindow();
+		m_pPresentQueue->Submit(m_pBackBuffer);
+	}
+	else if (m_pWindow != nullptr)
+	{
+		DAE_PROFILE_SCOPE("SoftwareRenderer::Present");
 
-				rasterVertices.push_back(newVertex);
-			}
+		// Only a window surface in an odd format needs the converting blit
+		if (m_pBackBuffer != m_pFrontBuffer) SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
+		SDL_UpdateWindowSurface(m_pWindow);
+	}
 
+	const Clock::time_point frameEndTime{ Clock::now() };
+	m_FrameTimings.presentMs = getMilliseconds(frameStartTime, acquireEndTime) + getMilliseconds(upscaleEndTime, frameEndTime);
+	m_FrameTimings.totalMs = getMilliseconds(frameStartTime, frameEndTime);
 
-			// RasterVertices
-			const Vector2 rasterVector0{ rasterVertices[0].Position.x,rasterVertices[0].Position.y };
-			const Vector2 rasterVector1{ rasterVertices[1].Position.x,rasterVertices[1].Position.y };
-			const Vector2 rasterVector2{ rasterVertices[2].Position.x,rasterVertices[2].Position.y };
+	// Present doesn't depend on the internal resolution, so it stays out of the measured cost
+	if (m_UseDynamicResolution)
+	{
+		UpdateResolutionScale(m_FrameTimings.totalMs - m_FrameTimings.presentMs);
+	}
+}
 
+void SoftwareRenderer::UpdateResolutionScale(double frameMs)
+{
+	// Raster, shading and resolve go with the pixel count, estimate what the window size would have cost
+	const float renderedFraction{ static_cast<float>(m_Width * m_Height) / (m_WindowWidth * m_WindowHeight) };
+	const float fullResolutionMs{ static_cast<float>(frameMs) / renderedFraction };
+	m_FullResolutionFrameMs = m_FullResolutionFrameMs > 0.f
+		? m_FullResolutionFrameMs + (fullResolutionMs - m_FullResolutionFrameMs) * m_FrameCostSmoothing
+		: fullResolutionMs;
+
+	// The scale is per axis, the cost goes with its square
+	const float desiredScale{ std::clamp(std::sqrt(m_TargetFrameMs / m_FullResolutionFrameMs), m_MinResolutionScale, 1.f) };
+
+	// Small steps would only make the resolution flicker, the limits are always reached though
+	if (std::abs(desiredScale - m_ResolutionScale) > m_ResolutionScaleDeadband || desiredScale == 1.f || desiredScale == m_MinResolutionScale)
+	{
+		m_ResolutionScale = desiredScale;
+	}
+}
 
-			////////////////////////
-			// -- BOUNDING BOX -- //
-			////////////////////////
+void SoftwareRenderer::SetupTriangles(const Mesh& mesh)
+{
+	DAE_PROFILE_SCOPE("SoftwareRenderer::SetupTriangles");
 
-			// TopRight
-			Vector2 topRightPoint{};
-			topRightPoint.x = std::max(std::max(rasterVector0.x, rasterVector1.x), rasterVector2.x);
-			topRightPoint.y = std::max(std::max(rasterVector0.y, rasterVector1.y), rasterVector2.y);
+	// For every triangle
+	const size_t triangleCount{ GetTriangleCount(mesh) };
+	for (size_t triangleIdx{}; triangleIdx < triangleCount; ++triangleIdx)
+	{
+		// Facing the wrong way, its vertices might not even be transformed
+		if (!m_pTriangleVisible[triangleIdx]) continue;
 
-			// Limit point to screenBoundaries
-			topRightPoint.x = Clamp(topRightPoint.x, 0.f, static_cast<float>(m_Width));
-			topRightPoint.y = Clamp(topRightPoint.y, 0.f, static_cast<float>(m_Height));
+		// VertexIndices
+		uint32_t indices[3]{};
+		GetTriangleIndices(mesh, triangleIdx, indices);
 
+		const uint32_t firstIndex{ indices[0] };
+		const uint32_t secondIndex{ indices[1] };
+		const uint32_t thirdIndex{ indices[2] };
 
-			// BottomLeft
-			Vector2 bottomLeftPoint{};
-			bottomLeftPoint.x = std::min(std::min(rasterVector0.x, rasterVector1.x), rasterVector2.x);
-			bottomLeftPoint.y = std::min(std::min(rasterVector0.y, rasterVector1.y), rasterVector2.y);
 
-			// Limit point to screenBoundaries
-			bottomLeftPoint.x = Clamp(bottomLeftPoint.x, 0.f, static_cast<float>(m_Width));
-			bottomLeftPoint.y = Clamp(bottomLeftPoint.y, 0.f, static_cast<float>(m_Height));
+		////////////////////
+		// -- Clipping -- //
+		////////////////////
 
+		const uint16_t firstOutCode{ ComputeOutCode(m_VerticesOut.GetPosition(firstIndex)) };
+		const uint16_t secondOutCode{ ComputeOutCode(m_VerticesOut.GetPosition(secondIndex)) };
+		const uint16_t thirdOutCode{ ComputeOutCode(m_VerticesOut.GetPosition(thirdIndex)) };
 
-			// For every pixel
-			for (int py{ static_cast<int>(bottomLeftPoint.y - 1) }; py < static_cast<int>(topRightPoint.y + 1); ++py)
-			{
-				for (int px{ static_cast<int>(bottomLeftPoint.x - 1) }; px < static_cast<int>(topRightPoint.x + 1); ++px)
-				{
-					const int pixelIndex{ py * m_Width + px };
-					const Vector2 pixelPos{ static_cast<float>(px), static_cast<float>(py) };
+		// All vertices outside of the same plane, can't be visible
+		if (firstOutCode & secondOutCode & thirdOutCode)
+		{
+			continue;
+		}
 
-					ColorRGB finalColor{};
+		// Common case, nothing crosses near, far or the guard band
+		const uint16_t clipPlanes{ static_cast<uint16_t>((firstOutCode | secondOutCode | thirdOutCode) & m_ClipPlaneMask) };
+		if (clipPlanes == 0)
+		{
+			SetupTriangle(firstIndex, secondIndex, thirdIndex);
+			continue;
+		}
 
-					// If should show boundingBoxes, skip calculation
-					if (m_ShowBoundingBoxes)
-					{
-						finalColor = ColorRGB{ 1,1,1 };
+		// Clip into a convex polygon and fan it back into triangles, winding stays the same
+		// New vertices go to the end of the streams, so setup can keep reading by index
+		const VS_OUPUT clipVertices[3]{ m_VerticesOut.Gather(firstIndex), m_VerticesOut.Gather(secondIndex), m_VerticesOut.Gather(thirdIndex) };
+		VS_OUPUT clippedVertices[m_MaxClippedVertices]{};
+		const int clippedVertexCount{ ClipTriangle(clipVertices, clipPlanes, clippedVertices) };
+		if (clippedVertexCount < 3) continue;
 
-						//Update Color in Buffer
-						finalColor.MaxToOne();
+		const uint32_t fanIndex{ PushClippedVertex(clippedVertices[0]) };
+		uint32_t previousIndex{ PushClippedVertex(clippedVertices[1]) };
+		for (int vertexIdx{ 2 }; vertexIdx < clippedVertexCount; ++vertexIdx)
+		{
+			const uint32_t currentIndex{ PushClippedVertex(clippedVertices[vertexIdx]) };
+			SetupTriangle(fanIndex, previousIndex, currentIndex);
+			previousIndex = currentIndex;
+		}
+	}
+}
 
-						m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-							static_cast<uint8_t>(finalColor.r * 255),
-							static_cast<uint8_t>(finalColor.g * 255),
-							static_cast<uint8_t>(finalColor.b * 255));
+size_t SoftwareRenderer::GetTriangleCount(const Mesh& mesh) const
+{
+	// Triangle count depends on primitiveTopolgy
+	if (mesh.indices.size() < 3) return 0;
 
-						continue;
-					}
+	const bool usingStripTopology{ mesh.primitiveTopology == PrimitiveTopology::TriangleStrip };
+	return usingStripTopology ? mesh.indices.size() - 2 : mesh.indices.size() / 3;
+}
 
-					///////////////////
-					// -- Weights -- //
-					///////////////////
+void SoftwareRenderer::GetTriangleIndices(const Mesh& mesh, size_t triangleIdx, uint32_t indices[3]) const
+{
+	const bool usingStripTopology{ mesh.primitiveTopology == PrimitiveTopology::TriangleStrip };
+	const size_t firstIdx{ usingStripTopology ? triangleIdx : triangleIdx * 3 };
 
-					const Vector2 firstEdge{ rasterVector1 - rasterVector0 };
-					const Vector2 secondEdge{ rasterVector2 - rasterVector1 };
-					const Vector2 thirdEdge{ rasterVector0 - rasterVector2 };
+	indices[0] = mesh.indices[firstIdx];
+	indices[1] = mesh.indices[firstIdx + 1];
+	indices[2] = mesh.indices[firstIdx + 2];
 
-					const float totalParallelogramArea{ Vector2::Cross(firstEdge,-thirdEdge) };
+	// Swap second and third index with triangleStrip
+	const bool triangleIsOdd{ triangleIdx % 2 == 1 };
+	if (usingStripTopology && triangleIsOdd)
+	{
+		std::swap(indices[1], indices[2]);
+	}
+}
 
-					const float W0{ Vector2::Cross(secondEdge, pixelPos - rasterVector1) / totalParallelogramArea };
-					const float W1{ Vector2::Cross(thirdEdge , pixelPos - rasterVector2) / totalParallelogramArea };
-					const float W2{ Vector2::Cross(firstEdge , pixelPos - rasterVector0) / totalParallelogramArea };
+std::vector<SoftwareRenderer::FacePlane> SoftwareRenderer::CreateFacePlanes(const Mesh& mesh) const
+{
+	// Object space, so they only need to be built once
+	const size_t triangleCount{ GetTriangleCount(mesh) };
+	std::vector<FacePlane> facePlanes(triangleCount);
 
-					// Culling
-					bool shouldRender{ false };
-					switch (*m_pCurrentCullingMode)
-					{
-					case backFace:
-						shouldRender = 0 < totalParallelogramArea;
-						break;
+	for (size_t triangleIdx{}; triangleIdx < triangleCount; ++triangleIdx)
+	{
+		uint32_t indices[3]{};
+		GetTriangleIndices(mesh, triangleIdx, indices);
 
-					case frontFace:
-						shouldRender = totalParallelogramArea <= 0;
-						break;
+		const Vector3& firstPosition{ mesh.vertices[indices[0]].Position };
+		const Vector3& secondPosition{ mesh.vertices[indices[1]].Position };
+		const Vector3& thirdPosition{ mesh.vertices[indices[2]].Position };
 
-					case noCulling:
-						shouldRender = true;
-						break;
-					}
+		FacePlane& facePlane{ facePlanes[triangleIdx] };
+		facePlane.normal = Vector3::Cross(secondPosition - firstPosition, thirdPosition - firstPosition);
+		facePlane.distance = -Vector3::Dot(facePlane.normal, firstPosition);
+	}
 
-					// Check if the pixel is in it
-					const bool pixelInsideTriangleWeight{W0 > 0 && W1 > 0 && W2 > 0};
-					if (pixelInsideTriangleWeight && shouldRender)
-					{
+	return facePlanes;
+}
 
+void SoftwareRenderer::CullTriangles(const Mesh& mesh, const std::vector<FacePlane>& facePlanes, const Matrix& worldMatrix)
+{
+	DAE_PROFILE_SCOPE("SoftwareRenderer::CullTriangles");
 
-						///////////////////
-						// -- Z Depth -- //
-						///////////////////
+	const size_t triangleCount{ GetTriangleCount(mesh) };
+	m_pTriangleVisible = m_pFrameArena->Allocate<uint8_t>(triangleCount);
+	m_pVertexUsed = m_pFrameArena->Allocate<uint8_t>(mesh.vertices.size());
+	std::fill_n(m_pTriangleVisible, triangleCount, static_cast<uint8_t>(true));
 
-						const float firstZDepth{ rasterVertices[0].Position.z };
-						const float secondZDepth{ rasterVertices[1].Position.z };
-						const float thirdZDepth{ rasterVertices[2].Position.z };
+	// Without culling every vertex is needed
+	const CullingMode cullingMode{ *m_pCurrentCullingMode };
+	if (cullingMode == noCulling)
+	{
+		std::fill_n(m_pVertexUsed, mesh.vertices.size(), static_cast<uint8_t>(true));
+		return;
+	}
 
-						const float interpolatedZDepth{ 1 / ((1 / firstZDepth) * W0 + (1 / secondZDepth) * W1 + (1 / thirdZDepth) * W2) };
+	std::fill_n(m_pVertexUsed, mesh.vertices.size(), static_cast<uint8_t>(false));
 
-						// Depth test
-						const bool isCloserThenDepthBuffer{ interpolatedZDepth < m_pDepthBufferPixels[pixelIndex] };
-						if (isCloserThenDepthBuffer)
-						{
-							m_pDepthBufferPixels[pixelIndex] = interpolatedZDepth;
+	// Camera in object space, a mirroring world matrix flips the winding on screen
+	const Vector3 cameraOrigin{ Matrix::Inverse(worldMatrix).TransformPoint(m_CameraOrigin) };
+	const float windingSign{ Vector3::Dot(Vector3::Cross(worldMatrix.GetAxisX(), worldMatrix.GetAxisY()), worldMatrix.GetAxisZ()) < 0.f ? -1.f : 1.f };
 
+	for (size_t triangleIdx{}; triangleIdx < triangleCount; ++triangleIdx)
+	{
+		const FacePlane& facePlane{ facePlanes[triangleIdx] };
 
-							//////////////
-							// -- UV -- //
-							//////////////
+		// Same sign as the screen-space area, positive when the camera sees the front
+		const float cameraSide{ Vector3::Dot(facePlane.normal, cameraOrigin) };
+		const float facing{ (cameraSide + facePlane.distance) * windingSign };
 
-							const Vector2 firstUV{ rasterVertices[0].UV };
-							const Vector2 secondUV{ rasterVertices[1].UV };
-							const Vector2 thirdUV{ rasterVertices[2].UV };
+		// Only cull clear cases, nearly edge-on triangles are left to the screen-space test
+		const float tolerance{ (std::abs(cameraSide) + std::abs(facePlane.distance)) * m_FaceCullingEpsilon };
+		const bool isCulled{ cullingMode == backFace ? facing < -tolerance : facing > tolerance };
+		if (isCulled)
+		{
+			m_pTriangleVisible[triangleIdx] = false;
+			continue;
+		}
 
-							// W Depth
-							const float firstWDepth{ rasterVertices[0].Position.w };
-							const float secondWDepth{ rasterVertices[1].Position.w };
-							const float thirdWDepth{ rasterVertices[2].Position.w };
+		uint32_t indices[3]{};
+		GetTriangleIndices(mesh, triangleIdx, indices);
+		for (const uint32_t vertexIdx : indices)
+		{
+			m_pVertexUsed[vertexIdx] = true;
+		}
+	}
+}
 
-							const float interpolatedWDepth{ 1 / ((1 / firstWDepth) * W0 + (1 / secondWDepth) * W1 + (1 / thirdWDepth) * W2) };
+bool SoftwareRenderer::IsCulled(int64_t totalParallelogramArea) const
+{
+	switch (*m_pCurrentCullingMode)
+	{
+	case backFace:
+		return totalParallelogramArea <= 0;
 
-							// Interpolate UV
-							const Vector2 interpolatedUV{ ((firstUV / firstWDepth) * W0 + (secondUV / secondWDepth) * W1 + (thirdUV / thirdWDepth) * W2) * interpolatedWDepth };
-							const ColorRGB uvColor{ m_pDiffuseTexture->Sample(interpolatedUV) };
+	case frontFace:
+		return 0 < totalParallelogramArea;
 
+	case noCulling:
+	default:
+		return false;
+	}
+}
 
-							///////////////////
-							// -- Shading -- //
-							///////////////////
+uint16_t SoftwareRenderer::ComputeOutCode(const Vector4& position) const
+{
+	uint16_t outCode{};
 
-							Vector3 desiredNormal{};
+	// Planes that get clipped
+	for (int planeIdx{}; planeIdx < m_ClipPlaneCount; ++planeIdx)
+	{
+		if (GetClipDistance(position, planeIdx) < 0.f)
+		{
+			outCode |= static_cast<uint16_t>(1 << planeIdx);
+		}
+	}
 
-							// Interpolate Normal
-							const Vector3 firstNormal{ rasterVertices[0].normal };
-							const Vector3 secondNormal{ rasterVertices[1].normal };
-							const Vector3 thirdNormal{ rasterVertices[2].normal };
+	// Screen sides, only used to reject, the rasterizer clamps to the screen
+	if (position.x < -position.w) outCode |= static_cast<uint16_t>(1 << (m_ClipPlaneCount + 0));
+	if (position.x > position.w)  outCode |= static_cast<uint16_t>(1 << (m_ClipPlaneCount + 1));
+	if (position.y < -position.w) outCode |= static_cast<uint16_t>(1 << (m_ClipPlaneCount + 2));
+	if (position.y > position.w)  outCode |= static_cast<uint16_t>(1 << (m_ClipPlaneCount + 3));
 
-							const Vector3 interpolatedNormal{ ((firstNormal / firstWDepth) * W0 + (secondNormal / secondWDepth) * W1 + (thirdNormal / thirdWDepth) * W2) * interpolatedWDepth };
-							desiredNormal = interpolatedNormal;
+	return outCode;
+}
 
-							// Interpolate Tangent
-							const Vector3 firstTangent{ rasterVertices[0].tangent };
-							const Vector3 secondTangent{ rasterVertices[1].tangent };
-							const Vector3 thirdTangent{ rasterVertices[2].tangent };
+float SoftwareRenderer::GetClipDistance(const Vector4& position, int planeIdx) const
+{
+	// Positive inside, D3D depth range goes from 0 to w
+	switch (planeIdx)
+	{
+	case 0: return position.z;								// Near
+	case 1: return position.w - position.z;					// Far
+	case 2: return position.x + m_GuardBandX * position.w;	// Guard band left
+	case 3: return m_GuardBandX * position.w - position.x;	// Guard band right
+	case 4: return position.y + m_GuardBandY * position.w;	// Guard band bottom
+	case 5: return m_GuardBandY * position.w - position.y;	// Guard band top
+	}
 
-							const Vector3 interpolatedTangent{ ((firstTangent / firstWDepth) * W0 + (secondTangent / secondWDepth) * W1 + (thirdTangent / thirdWDepth) * W2) * interpolatedWDepth };
+	return 0.f;
+}
 
-							// Tangent space transformation matrix
-							if (m_UseNormalMap)
-							{
-								// Sample normal
-								const ColorRGB normalColor{ m_pNormalTexture->Sample(interpolatedUV) };
-								Vector3 sampledNormal{ normalColor.r, normalColor.g, normalColor.b };
-								sampledNormal = 2.f * sampledNormal - Vector3{ 1.f, 1.f, 1.f };
-
-								// Create tangentSpaceAxis
-								const Vector3 binormal{ Vector3::Cross(interpolatedNormal,interpolatedTangent) };
-								Matrix tangentSpaceAxis{};
-
-								tangentSpaceAxis[0] = { interpolatedTangent, 0 };
-								tangentSpaceAxis[1] = { binormal,0 };
-								tangentSpaceAxis[2] = { interpolatedNormal,0 };
-								tangentSpaceAxis[3] = { 0,0,0,0 };
-
-								// Multiply sampledNormal with matrix
-								desiredNormal = tangentSpaceAxis.TransformVector(sampledNormal);
-							}
+int SoftwareRenderer::ClipTriangle(const VS_OUPUT vertices[3], uint16_t clipPlanes, VS_OUPUT* pClippedVertices) const
+{
+	// Sutherland-Hodgman, every plane adds at most one vertex
+	VS_OUPUT scratchVertices[m_MaxClippedVertices]{};
+	VS_OUPUT* pInput{ pClippedVertices };
+	VS_OUPUT* pOutput{ scratchVertices };
 
-							// Interpolate viewDirection
-							const Vector3 cameraOrigin{ m_pCamera->GetOrigin() };
+	int vertexCount{ 3 };
+	for (int vertexIdx{}; vertexIdx < 3; ++vertexIdx)
+	{
+		pInput[vertexIdx] = vertices[vertexIdx];
+	}
 
-							const Vector3 firstViewDirection{ (Vector3{rasterVertices[0].Position.x, rasterVertices[0].Position.y, rasterVertices[0].Position.z} - cameraOrigin).Normalized() };
-							const Vector3 secondViewDirection{ (Vector3{rasterVertices[1].Position.x, rasterVertices[1].Position.y, rasterVertices[1].Position.z} - cameraOrigin).Normalized() };
-							const Vector3 thirdViewDirection{ (Vector3{rasterVertices[2].Position.x, rasterVertices[2].Position.y, rasterVertices[2].Position.z} - cameraOrigin).Normalized() };
+	for (int planeIdx{}; planeIdx < m_ClipPlaneCount; ++planeIdx)
+	{
+		if ((clipPlanes & (1 << planeIdx)) == 0) continue;
 
-							const Vector3 interpolatedViewDirection{ ((firstViewDirection / firstWDepth) * W0 + (secondViewDirection / secondWDepth) * W1 + (thirdViewDirection / thirdWDepth) * W2) * interpolatedWDepth };
+		int outputCount{};
+		for (int vertexIdx{}; vertexIdx < vertexCount; ++vertexIdx)
+		{
+			const VS_OUPUT& currentVertex{ pInput[vertexIdx] };
+			const VS_OUPUT& nextVertex{ pInput[(vertexIdx + 1) % vertexCount] };
 
-							// Collecting all interpolations
-							VS_OUPUT shadingVertex{};
-							shadingVertex.Position = Vector4{ pixelPos.x,pixelPos.y,interpolatedZDepth,interpolatedWDepth };
-							shadingVertex.Color = uvColor;
-							shadingVertex.UV = interpolatedUV;
-							shadingVertex.normal = desiredNormal;
-							shadingVertex.tangent = interpolatedTangent;
-							shadingVertex.viewDirection = interpolatedViewDirection;
+			const float currentDistance{ GetClipDistance(currentVertex.Position, planeIdx) };
+			const float nextDistance{ GetClipDistance(nextVertex.Position, planeIdx) };
+			const bool currentIsInside{ currentDistance >= 0.f };
+			const bool nextIsInside{ nextDistance >= 0.f };
 
-							// Actual shading
-							const ColorRGB shadedColor{ PixelShading(shadingVertex) };
+			if (currentIsInside)
+			{
+				pOutput[outputCount++] = currentVertex;
+			}
 
+			// Always interpolate from the inside vertex, so a shared edge clips to the same point in both triangles
+			if (currentIsInside != nextIsInside)
+			{
+				pOutput[outputCount++] = currentIsInside
+					? InterpolateVertex(currentVertex, nextVertex, currentDistance / (currentDistance - nextDistance))
+					: InterpolateVertex(nextVertex, currentVertex, nextDistance / (nextDistance - currentDistance));
+			}
+		}
 
-							//////////////////////
-							// -- Show Color -- //
-							//////////////////////
+		std::swap(pInput, pOutput);
+		vertexCount = outputCount;
 
-							// Switch between showing finalColor and depthBuffer
-							if (!m_ShowDepthBuffer)
-							{
-								finalColor = shadedColor;
-							}
-							else
-							{
-								const float remapValue{ InverseLerp(.985f,1.f,interpolatedZDepth) };
-								const ColorRGB depthBufferColor{ remapValue, remapValue, remapValue };
+		if (vertexCount < 3) return 0;
+	}
 
-								finalColor = depthBufferColor;
-							}
+	// Result has to end up in the caller's array
+	if (pInput != pClippedVertices)
+	{
+		std::copy(pInput, pInput + vertexCount, pClippedVertices);
+	}
 
+	return vertexCount;
+}
 
-							//Update Color in Buffer
-							finalColor.MaxToOne();
+float SoftwareRenderer::GetDepthKey(const VertexStreams& vertices, uint32_t idx) const
+{
+	switch (m_DepthFormat)
+	{
+	case DepthFormat::ReversedFloat32:
+		// Near is -1 and far is 0, floats are densest around 0 which is where depth needs them
+		// Computed before the divide, 1 - z/w would throw that precision away again
+		return -((vertices.positionW[idx] - vertices.positionZ[idx]) / vertices.positionW[idx]);
+	case DepthFormat::Unorm24:
+		return vertices.rasterZ[idx] * GetDepthScale<DepthFormat::Unorm24>();
+	case DepthFormat::Unorm16:
+		return vertices.rasterZ[idx] * GetDepthScale<DepthFormat::Unorm16>();
+	default:
+		return vertices.rasterZ[idx];
+	}
+}
 
-							m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-								static_cast<uint8_t>(finalColor.r * 255),
-								static_cast<uint8_t>(finalColor.g * 255),
-								static_cast<uint8_t>(finalColor.b * 255));
-						}
-					}
-				}
-			}
-		}
+float SoftwareRenderer::DecodeDepth(float depthKey) const
+{
+	// Back to z/w, for shading and the depth view
+	switch (m_DepthFormat)
+	{
+	case DepthFormat::ReversedFloat32:
+		return 1.f + depthKey;
+	case DepthFormat::Unorm24:
+		return depthKey / GetDepthScale<DepthFormat::Unorm24>();
+	case DepthFormat::Unorm16:
+		return depthKey / GetDepthScale<DepthFormat::Unorm16>();
+	default:
+		return depthKey;
 	}
+}
 
-	//@END
-	//Update SDL Surface
-	SDL_UnlockSurface(m_pBackBuffer);
-	SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-	SDL_UpdateWindowSurface(m_pWindow);
+VS_OUPUT SoftwareRenderer::InterpolateVertex(const VS_OUPUT& from, const VS_OUPUT& to, float t)
+{
+	// Clip space is before the divide, so everything interpolates linearly
+	VS_OUPUT vertex{};
+	vertex.Position = from.Position + (to.Position - from.Position) * t;
+	vertex.UV = from.UV + (to.UV - from.UV) * t;
+	vertex.normal = from.normal + (to.normal - from.normal) * t;
+	vertex.tangent = from.tangent + (to.tangent - from.tangent) * t;
+
+	return vertex;
 }
 
-void SoftwareRenderer::VertexTransformationFunction(const std::vector<VS_INPUT>& vertices_in, std::vector<VS_OUPUT>& vertices_out, const Matrix& worldMatrix) const
+void SoftwareRenderer::SetupTriangle(uint32_t firstIndex, uint32_t secondIndex, uint32_t thirdIndex)
 {
-	vertices_out.reserve(vertices_in.size());
+	const VertexStreams& vertices{ m_VerticesOut };
+	const uint32_t indices[3]{ firstIndex, secondIndex, thirdIndex };
 
-	const Matrix cameraInvViewMatrix{ m_pCamera->GetInvViewMatrix() };
-	const Matrix cameraProjectionMatrix{ m_pCamera->GetProjectionMatrix() };
+	// Raster-space, the transform already did the perspective divide
+	TriangleSetup triangle{};
+	Vector3 rasterPositions[3]{};
+	for (size_t vertexIdx{}; vertexIdx < 3; ++vertexIdx)
+	{
+		const uint32_t idx{ indices[vertexIdx] };
+		rasterPositions[vertexIdx] = Vector3{ vertices.rasterX[idx], vertices.rasterY[idx], vertices.rasterZ[idx] };
+	}
 
-	const Matrix viewMatrix{ cameraInvViewMatrix };
-	const Matrix projectionMatrix{ cameraProjectionMatrix };
-	const Matrix worldViewProjectionMatrix{ worldMatrix * viewMatrix * projectionMatrix };
+	// Snap to sub-pixel fixed point
+	int32_t fixedX[3]{};
+	int32_t fixedY[3]{};
+	for (size_t vertexIdx{}; vertexIdx < 3; ++vertexIdx)
+	{
+		fixedX[vertexIdx] = static_cast<int32_t>(std::floor(rasterPositions[vertexIdx].x * m_SubPixelSteps + 0.5f));
+		fixedY[vertexIdx] = static_cast<int32_t>(std::floor(rasterPositions[vertexIdx].y * m_SubPixelSteps + 0.5f));
+	}
+
+
+	/////////////////
+	// -- Edges -- //
+	/////////////////
 
-	for (const auto& currentVertex : vertices_in)
+	// Same orientation as Vector2::Cross(firstEdge, -thirdEdge)
+	int64_t totalParallelogramArea{ static_cast<int64_t>(fixedX[1] - fixedX[0]) * (fixedY[2] - fixedY[0])
+									- static_cast<int64_t>(fixedY[1] - fixedY[0]) * (fixedX[2] - fixedX[0]) };
+
+	// Degenerate, covers no pixels
+	if (totalParallelogramArea == 0)
 	{
-		Vector4 transformedPosition{ currentVertex.Position, 0 };
-		transformedPosition = worldViewProjectionMatrix.TransformPoint(transformedPosition);;
+		return;
+	}
 
-		// Perspective Divide
-		transformedPosition.x /= transformedPosition.w;
-		transformedPosition.y /= transformedPosition.w;
-		transformedPosition.z /= transformedPosition.w;
+	// Final say on culling, once per triangle instead of per tile
+	if (IsCulled(totalParallelogramArea))
+	{
+		return;
+	}
 
-		// Put in vertexOut
-		VS_OUPUT tempVertex{};
-		tempVertex.Position = transformedPosition;
-		tempVertex.Color = ColorRGB{ currentVertex.Color.x, currentVertex.Color.y,currentVertex.Color.z };
-		tempVertex.UV = currentVertex.UV;
+	// Edge i lies opposite of vertex i, so its value is the weight of vertex i
+	const bool isClockwise{ totalParallelogramArea < 0 };
+	for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+	{
+		const int startIdx{ (edgeIdx + 1) % 3 };
+		const int endIdx{ (edgeIdx + 2) % 3 };
+
+		EdgeFunction& edge{ triangle.edges[edgeIdx] };
+		edge.a = -static_cast<int64_t>(fixedY[endIdx] - fixedY[startIdx]);
+		edge.b = static_cast<int64_t>(fixedX[endIdx] - fixedX[startIdx]);
+		edge.c = -edge.a * fixedX[startIdx] - edge.b * fixedY[startIdx];
 
-		tempVertex.normal = worldMatrix.TransformVector(currentVertex.normal);
-		tempVertex.tangent = worldMatrix.TransformVector(currentVertex.tangent);
+		// Make the inside positive for both windings
+		if (isClockwise)
+		{
+			edge.a = -edge.a;
+			edge.b = -edge.b;
+			edge.c = -edge.c;
+		}
 
-		vertices_out.emplace_back(tempVertex);
+		// Top-left rule: pixels exactly on a top or left edge are in, on other edges out
+		const bool isTopLeftEdge{ edge.a > 0 || (edge.a == 0 && edge.b > 0) };
+		edge.bias = isTopLeftEdge ? 0 : -1;
+		edge.c += edge.bias;
+
+		edge.stepX = edge.a * m_SubPixelSteps;
+		edge.stepY = edge.b * m_SubPixelSteps;
 	}
-}
 
-bool SoftwareRenderer::SaveBufferToImage() const
-{
-	return SDL_SaveBMP(m_pBackBuffer, "Rasterizer_ColorBuffer.bmp");
-}
 
-void SoftwareRenderer::ToggleFilter()
-{
-	m_ShowDepthBuffer = !m_ShowDepthBuffer;
+	////////////////////////
+	// -- BOUNDING BOX -- //
+	////////////////////////
 
-	if (m_ShowDepthBuffer)
+	// Only pixels with their center inside the box, clipped to the screen
+	// Multisampled, every pixel with any of its samples inside
+	const int32_t minFixedX{ std::min(std::min(fixedX[0], fixedX[1]), fixedX[2]) };
+	const int32_t minFixedY{ std::min(std::min(fixedY[0], fixedY[1]), fixedY[2]) };
+	const int32_t maxFixedX{ std::max(std::max(fixedX[0], fixedX[1]), fixedX[2]) };
+	const int32_t maxFixedY{ std::max(std::max(fixedY[0], fixedY[1]), fixedY[2]) };
+
+	const int32_t halfPixel{ m_SubPixelSteps / 2 };
+	const int32_t sampleReach{ m_UseMsaa ? m_MaxSampleOffset : 0 };
+	triangle.minX = std::max((minFixedX - halfPixel - sampleReach + m_SubPixelSteps - 1) >> m_SubPixelBits, 0);
+	triangle.minY = std::max((minFixedY - halfPixel - sampleReach + m_SubPixelSteps - 1) >> m_SubPixelBits, 0);
+	triangle.maxX = std::min(((maxFixedX - halfPixel + sampleReach) >> m_SubPixelBits) + 1, m_Width);
+	triangle.maxY = std::min(((maxFixedY - halfPixel + sampleReach) >> m_SubPixelBits) + 1, m_Height);
+
+	if (triangle.minX >= triangle.maxX || triangle.minY >= triangle.maxY)
 	{
-		std::cout << "Enabled depth-buffer" << std::endl;
+		return;
 	}
-	else
+
+	// Small enough for a stamp, test its coverage right away
+	// Triangles slipping between the pixel centers or samples are done here, before any attribute plane gets built
+	triangle.isSmall = triangle.maxX - triangle.minX <= m_StampSize && triangle.maxY - triangle.minY <= m_StampSize;
+	if (triangle.isSmall)
 	{
-		std::cout << "Disabled depth-buffer" << std::endl;
+		triangle.stampCoverage = GetStampCoverage(triangle);
+		if (triangle.stampCoverage == 0) return;
 	}
-}
-void SoftwareRenderer::ToggleShadingMode()
-{
-	switch (m_CurrentShadingMode)
+
+	// Depth, only for triangles that made it this far
+	float inverseWDepths[3]{};
+	float depthKeys[3]{};
+	for (size_t vertexIdx{}; vertexIdx < 3; ++vertexIdx)
 	{
-	case shadingModes::ObservedArea:
-		m_CurrentShadingMode = shadingModes::Diffuse;
-		std::cout << "Current shadingMode is diffuse" << std::endl;
-		break;
+		inverseWDepths[vertexIdx] = vertices.inverseW[indices[vertexIdx]];
+		depthKeys[vertexIdx] = GetDepthKey(vertices, indices[vertexIdx]);
+	}
 
-	case shadingModes::Diffuse:
-		m_CurrentShadingMode = shadingModes::Specular;
-		std::cout << "Current shadingMode is specular" << std::endl;
-		break;
+	// Depth range for HiZ, interpolated depth stays between the vertex depths
+	triangle.minZDepth = std::min(std::min(depthKeys[0], depthKeys[1]), depthKeys[2]);
+	triangle.maxZDepth = std::max(std::max(depthKeys[0], depthKeys[1]), depthKeys[2]);
 
-	case shadingModes::Specular:
-		m_CurrentShadingMode = shadingModes::Combined;
-		std::cout << "Current shadingMode is combined" << std::endl;
-		break;
 
-	case shadingModes::Combined:
-		m_CurrentShadingMode = shadingModes::ObservedArea;
-		std::cout << "Current shadingMode is observedArea" << std::endl;
-		break;
-	}
-}
-void SoftwareRenderer::ToggleNormalMap()
-{
-	m_UseNormalMap = !m_UseNormalMap;
+	////////////////////////////
+	// -- Attribute Planes -- //
+	////////////////////////////
 
-	if (m_UseNormalMap)
+	// Built from the edge functions, so they agree exactly with the coverage test
+	// Everything is relative to the center of the first pixel to keep the floats small
+	const double invArea{ 1.0 / static_cast<double>(isClockwise ? -totalParallelogramArea : totalParallelogramArea) };
+	const int64_t firstSampleX{ static_cast<int64_t>(triangle.minX) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+	const int64_t firstSampleY{ static_cast<int64_t>(triangle.minY) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+
+	double weights[3]{};
+	double weightStepsX[3]{};
+	double weightStepsY[3]{};
+	for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
 	{
-		std::cout << "normalMap on!" << '\n';
+		const EdgeFunction& edge{ triangle.edges[edgeIdx] };
+		weights[edgeIdx] = static_cast<double>(edge.a * firstSampleX + edge.b * firstSampleY + edge.c - edge.bias) * invArea;
+		weightStepsX[edgeIdx] = static_cast<double>(edge.stepX) * invArea;
+		weightStepsY[edgeIdx] = static_cast<double>(edge.stepY) * invArea;
 	}
-	else
+
+	const auto createPlane = [&](float firstValue, float secondValue, float thirdValue)
+		{
+			AttributePlane plane{};
+			plane.a = static_cast<float>(firstValue * weightStepsX[0] + secondValue * weightStepsX[1] + thirdValue * weightStepsX[2]);
+			plane.b = static_cast<float>(firstValue * weightStepsY[0] + secondValue * weightStepsY[1] + thirdValue * weightStepsY[2]);
+			plane.c = static_cast<float>(firstValue * weights[0] + secondValue * weights[1] + thirdValue * weights[2]);
+			return plane;
+		};
+
+	// Depth after the divide is linear in screen space, a near-clipped vertex sits at depth 0
+	// Every depth format's key is a linear function of it, so one plane covers them all
+	triangle.zDepth = createPlane(depthKeys[0], depthKeys[1], depthKeys[2]);
+
+	// Perspective correct attributes, divided by w here and multiplied back per pixel
+	Vector3 viewDirections[3]{};
+	for (int vertexIdx{}; vertexIdx < 3; ++vertexIdx)
 	{
-		std::cout << "normalMap off!" << '\n';
+		viewDirections[vertexIdx] = (rasterPositions[vertexIdx] - m_CameraOrigin).Normalized() * inverseWDepths[vertexIdx];
 	}
-}
-void SoftwareRenderer::ToggleBoundingBox()
-{
-	m_ShowBoundingBoxes = !m_ShowBoundingBoxes;
 
-	if (m_ShowBoundingBoxes)
+	const auto createAttributePlane = [&](const std::vector<float>& stream)
+		{
+			return createPlane(stream[firstIndex] * inverseWDepths[0], stream[secondIndex] * inverseWDepths[1], stream[thirdIndex] * inverseWDepths[2]);
+		};
+
+	triangle.inverseWDepth = createPlane(inverseWDepths[0], inverseWDepths[1], inverseWDepths[2]);
+	triangle.uv[0] = createAttributePlane(vertices.u);
+	triangle.uv[1] = createAttributePlane(vertices.v);
+
+	const std::vector<float>* normalStreams[3]{ &vertices.normalX, &vertices.normalY, &vertices.normalZ };
+	const std::vector<float>* tangentStreams[3]{ &vertices.tangentX, &vertices.tangentY, &vertices.tangentZ };
+	for (int componentIdx{}; componentIdx < 3; ++componentIdx)
 	{
-		std::cout << "Enabled bounding-boxes visualization" << std::endl;
+		triangle.normal[componentIdx] = createAttributePlane(*normalStreams[componentIdx]);
+		triangle.tangent[componentIdx] = createAttributePlane(*tangentStreams[componentIdx]);
+		triangle.viewDirection[componentIdx] = createPlane(viewDirections[0][componentIdx], viewDirections[1][componentIdx], viewDirections[2][componentIdx]);
 	}
-	else
+
+
+	///////////////////
+	// -- BINNING -- //
+	///////////////////
+
+	const uint32_t triangleIdx{ static_cast<uint32_t>(m_Triangles.size()) };
+	m_Triangles.push_back(triangle);
+
+	const int firstTileX{ triangle.minX / m_TileSize };
+	const int firstTileY{ triangle.minY / m_TileSize };
+	const int lastTileX{ (triangle.maxX - 1) / m_TileSize };
+	const int lastTileY{ (triangle.maxY - 1) / m_TileSize };
+
+	for (int tileY{ firstTileY }; tileY <= lastTileY; ++tileY)
+	{
+		for (int tileX{ firstTileX }; tileX <= lastTileX; ++tileX)
+		{
+			AddToBin(m_TileBins[tileY * m_TileCountX + tileX], triangleIdx);
+		}
+	}
+}
+
+uint64_t SoftwareRenderer::GetStampCoverage(const TriangleSetup& triangle) const
+{
+	// Same edge values as the pixel loops, so the stamp covers exactly what they would
+	const int samplesPerPixel{ m_UseMsaa ? m_SampleCount : 1 };
+	const EdgeFunction* edges{ triangle.edges };
+
+	uint64_t coverage{};
+	for (int py{ triangle.minY }; py < triangle.maxY; ++py)
+	{
+		for (int px{ triangle.minX }; px < triangle.maxX; ++px)
+		{
+			const int firstBit{ ((py - triangle.minY) * m_StampSize + (px - triangle.minX)) * samplesPerPixel };
+			for (int sampleIdx{}; sampleIdx < samplesPerPixel; ++sampleIdx)
+			{
+				// Pixel center, multisampled one of the samples around it
+				const int64_t sampleX{ static_cast<int64_t>(px) * m_SubPixelSteps + m_SubPixelSteps / 2 + (m_UseMsaa ? m_SampleOffsetsX[sampleIdx] : 0) };
+				const int64_t sampleY{ static_cast<int64_t>(py) * m_SubPixelSteps + m_SubPixelSteps / 2 + (m_UseMsaa ? m_SampleOffsetsY[sampleIdx] : 0) };
+
+				const bool isInside{ ((edges[0].a * sampleX + edges[0].b * sampleY + edges[0].c)
+					| (edges[1].a * sampleX + edges[1].b * sampleY + edges[1].c)
+					| (edges[2].a * sampleX + edges[2].b * sampleY + edges[2].c)) >= 0 };
+				coverage |= static_cast<uint64_t>(isInside) << (firstBit + sampleIdx);
+			}
+		}
+	}
+
+	return coverage;
+}
+
+void SoftwareRenderer::AddToBin(TileBin& tileBin, uint32_t triangleIdx)
+{
+	// Start a new chunk when the last one is full
+	if (tileBin.pLastChunk == nullptr || tileBin.pLastChunk->count == m_BinChunkSize)
+	{
+		TileBinChunk* pChunk{ m_pFrameArena->Allocate<TileBinChunk>(1) };
+		pChunk->count = 0;
+		pChunk->pNext = nullptr;
+
+		if (tileBin.pLastChunk == nullptr) tileBin.pFirstChunk = pChunk;
+		else tileBin.pLastChunk->pNext = pChunk;
+		tileBin.pLastChunk = pChunk;
+	}
+
+	tileBin.pLastChunk->triangleIndices[tileBin.pLastChunk->count++] = triangleIdx;
+}
+
+void SoftwareRenderer::GetTileBounds(uint32_t tileIdx, int& minX, int& minY, int& maxX, int& maxY) const
+{
+	// Edge tiles get clipped to the render size
+	minX = static_cast<int>(tileIdx % m_TileCountX) * m_TileSize;
+	minY = static_cast<int>(tileIdx / m_TileCountX) * m_TileSize;
+	maxX = std::min(minX + m_TileSize, m_Width);
+	maxY = std::min(minY + m_TileSize, m_Height);
+}
+
+void SoftwareRenderer::RasterizeTile(uint32_t tileIdx)
+{
+	DAE_PROFILE_SCOPE("SoftwareRenderer::RasterizeTile");
+
+	// Tile pixel bounds
+	int tileMinX{}, tileMinY{}, tileMaxX{}, tileMaxY{};
+	GetTileBounds(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+
+	// Kernels are compiled per storage type, the float formats only differ in triangle setup
+	uint64_t depthPassedFragments{};
+	switch (m_DepthFormat)
+	{
+	case DepthFormat::Unorm24:
+		depthPassedFragments = RasterizeBin<DepthFormat::Unorm24>(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+		break;
+	case DepthFormat::Unorm16:
+		depthPassedFragments = RasterizeBin<DepthFormat::Unorm16>(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+		break;
+	default:
+		depthPassedFragments = RasterizeBin<DepthFormat::Float32>(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+		break;
+	}
+
+	// Forward shading shades every fragment that passes the depth test
+	ShadingStatistics& tileStatistics{ m_TileStatistics[tileIdx] };
+	tileStatistics.depthPassedFragments = depthPassedFragments;
+	tileStatistics.shadedPixels = m_UseDeferredShading ? 0 : depthPassedFragments;
+}
+
+template<SoftwareRenderer::DepthFormat format>
+uint64_t SoftwareRenderer::RasterizeBin(uint32_t tileIdx, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY)
+{
+	// First touch this frame, initialize the tile before drawing into it
+	if (m_TileBins[tileIdx].pFirstChunk != nullptr)
+	{
+		ClearTile<format>(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+	}
+
+	// Draw every triangle that touches this tile, in submission order
+	uint64_t depthPassedFragments{};
+	for (const TileBinChunk* pChunk{ m_TileBins[tileIdx].pFirstChunk }; pChunk != nullptr; pChunk = pChunk->pNext)
+	{
+		for (uint32_t chunkIdx{}; chunkIdx < pChunk->count; ++chunkIdx)
+		{
+			const uint32_t triangleIdx{ pChunk->triangleIndices[chunkIdx] };
+			const TriangleSetup& triangle{ m_Triangles[triangleIdx] };
+
+			depthPassedFragments += RasterizeTriangle<format>(triangleIdx,
+				std::max(triangle.minX, tileMinX), std::max(triangle.minY, tileMinY),
+				std::min(triangle.maxX, tileMaxX), std::min(triangle.maxY, tileMaxY));
+		}
+	}
+
+	return depthPassedFragments;
+}
+
+template<SoftwareRenderer::DepthFormat format>
+void SoftwareRenderer::ClearTile(uint32_t tileIdx, int minX, int minY, int maxX, int maxY)
+{
+	DAE_PROFILE_SCOPE("SoftwareRenderer::ClearTile");
+
+	const int pixelCount{ m_Width * m_Height };
+
+	// Multisampled, only the samples get cleared, the color resolve writes every pixel from them
+	// Depth compression doesn't apply, sample depth is always written right away
+	if (m_UseMsaa)
+	{
+		const int sampleCount{ pixelCount * m_SampleCount };
+		for (int py{ minY }; py < maxY; ++py)
+		{
+			const int firstSample{ (py * m_Width + minX) * m_SampleCount };
+			const int lastSample{ (py * m_Width + maxX) * m_SampleCount };
+			std::fill(m_pSampleColorPixels + firstSample, m_pSampleColorPixels + lastSample, m_ClearColor.r);
+			std::fill(m_pSampleColorPixels + sampleCount + firstSample, m_pSampleColorPixels + sampleCount + lastSample, m_ClearColor.g);
+			std::fill(m_pSampleColorPixels + sampleCount * 2 + firstSample, m_pSampleColorPixels + sampleCount * 2 + lastSample, m_ClearColor.b);
+
+			for (int sampleIndex{ firstSample }; sampleIndex < lastSample; ++sampleIndex)
+			{
+				StoreDepth<format>(m_pSampleDepthPixels, sampleIndex, m_DepthClearValue);
+			}
+		}
+
+		m_TileDepthStates[tileIdx] = TileDepthState::Expanded;
+	}
+	else
+	{
+		for (int py{ minY }; py < maxY; ++py)
+		{
+			const int rowIndex{ py * m_Width };
+			std::fill(m_pColorBufferPixels + rowIndex + minX, m_pColorBufferPixels + rowIndex + maxX, m_ClearColor.r);
+			std::fill(m_pColorBufferPixels + pixelCount + rowIndex + minX, m_pColorBufferPixels + pixelCount + rowIndex + maxX, m_ClearColor.g);
+			std::fill(m_pColorBufferPixels + pixelCount * 2 + rowIndex + minX, m_pColorBufferPixels + pixelCount * 2 + rowIndex + maxX, m_ClearColor.b);
+		}
+
+		// Compressed, the clear value is only written once something needs per-pixel depth
+		if (m_UseDepthCompression)
+		{
+			m_TileDepthStates[tileIdx] = TileDepthState::Cleared;
+		}
+		else
+		{
+			FillTileDepth<format>(tileIdx);
+		}
+	}
+
+	// Tiles are a whole number of HiZ blocks wide
+	const int blockMinX{ minX / m_HiZBlockSize };
+	const int blockMaxX{ (maxX + m_HiZBlockSize - 1) / m_HiZBlockSize };
+	for (int blockY{ minY / m_HiZBlockSize }; blockY < (maxY + m_HiZBlockSize - 1) / m_HiZBlockSize; ++blockY)
+	{
+		std::fill(m_HiZBlocks.begin() + blockY * m_HiZBlockCountX + blockMinX, m_HiZBlocks.begin() + blockY * m_HiZBlockCountX + blockMaxX, HiZBlock{ m_DepthClearValue, m_DepthClearValue });
+	}
+
+	m_TileCleared[tileIdx] = true;
+}
+
+template<SoftwareRenderer::DepthFormat format>
+void SoftwareRenderer::FillTileDepth(uint32_t tileIdx)
+{
+	// Tile pixel bounds
+	int tileMinX{}, tileMinY{}, tileMaxX{}, tileMaxY{};
+	GetTileBounds(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+
+	// Either the clear value or the plane of the triangle covering the tile
+	const TriangleSetup* pTriangle{ m_TileDepthStates[tileIdx] == TileDepthState::Planar ? &m_Triangles[m_TilePlanarTriangles[tileIdx]] : nullptr };
+
+	for (int py{ tileMinY }; py < tileMaxY; ++py)
+	{
+		for (int px{ tileMinX }; px < tileMaxX; ++px)
+		{
+			const float depthKey{ pTriangle != nullptr
+				? QuantizeDepth<format>(pTriangle->zDepth.Evaluate(static_cast<float>(px - pTriangle->minX), static_cast<float>(py - pTriangle->minY)))
+				: m_DepthClearValue };
+
+			StoreDepth<format>(m_pDepthBufferPixels, py * m_Width + px, depthKey);
+		}
+	}
+
+	m_TileDepthStates[tileIdx] = TileDepthState::Expanded;
+}
+
+void SoftwareRenderer::ResolveTile(uint32_t tileIdx)
+{
+	DAE_PROFILE_SCOPE("SoftwareRenderer::ResolveTile");
+
+	// Tile pixel bounds
+	int tileMinX{}, tileMinY{}, tileMaxX{}, tileMaxY{};
+	GetTileBounds(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+
+	// Shade the surviving fragments in cells of the block's shading rate, cells are single pixels at full rate
+	const uint8_t fixedRate{ m_ShadingRateMode == ShadingRateMode::Coarse ? static_cast<uint8_t>(m_CoarseShadingRateX | m_CoarseShadingRateY) : uint8_t{} };
+	uint64_t shadedPixels{};
+	for (int blockMinY{ tileMinY }; blockMinY < tileMaxY; blockMinY += m_ShadingRateBlockSize)
+	{
+		for (int blockMinX{ tileMinX }; blockMinX < tileMaxX; blockMinX += m_ShadingRateBlockSize)
+		{
+			const int blockMaxX{ std::min(blockMinX + m_ShadingRateBlockSize, tileMaxX) };
+			const int blockMaxY{ std::min(blockMinY + m_ShadingRateBlockSize, tileMaxY) };
+
+			const uint8_t rate{ m_ShadingRateMode == ShadingRateMode::Adaptive
+				? m_ShadingRates[(blockMinY / m_ShadingRateBlockSize) * m_ShadingRateBlockCountX + blockMinX / m_ShadingRateBlockSize]
+				: fixedRate };
+			const int cellWidth{ (rate & m_CoarseShadingRateX) != 0 ? m_CoarseCellSize : 1 };
+			const int cellHeight{ (rate & m_CoarseShadingRateY) != 0 ? m_CoarseCellSize : 1 };
+
+			for (int cellMinY{ blockMinY }; cellMinY < blockMaxY; cellMinY += cellHeight)
+			{
+				for (int cellMinX{ blockMinX }; cellMinX < blockMaxX; cellMinX += cellWidth)
+				{
+					shadedPixels += ShadeCell(cellMinX, cellMinY, std::min(cellMinX + cellWidth, blockMaxX), std::min(cellMinY + cellHeight, blockMaxY));
+				}
+			}
+		}
+	}
+
+	m_TileStatistics[tileIdx].shadedPixels = shadedPixels;
+}
+
+uint64_t SoftwareRenderer::ShadeCell(int minX, int minY, int maxX, int maxY)
+{
+	// Multisampled, the visibility buffer holds an id per sample
+	const int samplesPerPixel{ m_UseMsaa ? m_SampleCount : 1 };
+	const int cellWidth{ maxX - minX };
+
+	uint64_t shadeCount{};
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		for (int px{ minX }; px < maxX; ++px)
+		{
+			for (int sampleIdx{}; sampleIdx < samplesPerPixel; ++sampleIdx)
+			{
+				const uint32_t triangleIdx{ m_VisibilityTriangleIds[(py * m_Width + px) * samplesPerPixel + sampleIdx] };
+				if (triangleIdx == m_InvalidTriangleIdx) continue;
+
+				const TriangleSetup& triangle{ m_Triangles[triangleIdx] };
+
+				// Gather everything it has left in the cell, clearing those ids for the next frame
+				// Its covered positions add up in sub-pixel steps from the cell's first pixel center
+				int sampleMasks[m_MaxShadingCellPixelCount]{};
+				int64_t positionX{};
+				int64_t positionY{};
+				int positionCount{};
+				for (int cellY{ minY }; cellY < maxY; ++cellY)
+				{
+					for (int cellX{ minX }; cellX < maxX; ++cellX)
+					{
+						uint32_t* pTriangleIds{ m_VisibilityTriangleIds.data() + (cellY * m_Width + cellX) * samplesPerPixel };
+						int sampleMask{};
+						for (int otherIdx{}; otherIdx < samplesPerPixel; ++otherIdx)
+						{
+							if (pTriangleIds[otherIdx] != triangleIdx) continue;
+
+							sampleMask |= 1 << otherIdx;
+							pTriangleIds[otherIdx] = m_InvalidTriangleIdx;
+						}
+						if (sampleMask == 0) continue;
+
+						sampleMasks[(cellY - minY) * cellWidth + cellX - minX] = sampleMask;
+
+						const int64_t pixelX{ static_cast<int64_t>(cellX - minX) * m_SubPixelSteps };
+						const int64_t pixelY{ static_cast<int64_t>(cellY - minY) * m_SubPixelSteps };
+						if (m_UseMsaa)
+						{
+							// Same as forward shading, the full coverage counts and not only the samples left
+							const int coverageMask{ GetCoverageMask(triangle, cellX, cellY) };
+							for (int maskLeft{ coverageMask }; maskLeft != 0; maskLeft &= maskLeft - 1)
+							{
+								const int coveredIdx{ std::countr_zero(static_cast<uint32_t>(maskLeft)) };
+								positionX += pixelX + m_SampleOffsetsX[coveredIdx];
+								positionY += pixelY + m_SampleOffsetsY[coveredIdx];
+								++positionCount;
+							}
+						}
+						else
+						{
+							positionX += pixelX;
+							positionY += pixelY;
+							++positionCount;
+						}
+					}
+				}
+
+				// Centroid of the covered positions, always inside the triangle so attributes never extrapolate
+				// A single fully covered pixel lands on its center, same as full-rate shading
+				const float positionSteps{ static_cast<float>(positionCount * m_SubPixelSteps) };
+				const float dx{ static_cast<float>(minX - triangle.minX) + static_cast<float>(positionX) / positionSteps };
+				const float dy{ static_cast<float>(minY - triangle.minY) + static_cast<float>(positionY) / positionSteps };
+				const ColorRGB color{ ShadeFragment(triangle, dx, dy, triangle.zDepth.Evaluate(dx, dy)) };
+				++shadeCount;
+
+				for (int cellY{ minY }; cellY < maxY; ++cellY)
+				{
+					for (int cellX{ minX }; cellX < maxX; ++cellX)
+					{
+						const int sampleMask{ sampleMasks[(cellY - minY) * cellWidth + cellX - minX] };
+						if (sampleMask == 0) continue;
+
+						if (m_UseMsaa) WriteSampleColors(cellY * m_Width + cellX, sampleMask, color);
+						else WriteColor(cellY * m_Width + cellX, color);
+					}
+				}
+			}
+		}
+	}
+
+	return shadeCount;
+}
+
+void SoftwareRenderer::UpdateShadingRates(uint32_t tileIdx)
+{
+	DAE_PROFILE_SCOPE("SoftwareRenderer::UpdateShadingRates");
+
+	// Tile pixel bounds
+	int tileMinX{}, tileMinY{}, tileMaxX{}, tileMaxY{};
+	GetTileBounds(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+
+	const int pixelCount{ m_Width * m_Height };
+	const auto getLuminance = [this, pixelCount](int pixelIndex)
+		{
+			const float red{ std::min(m_pColorBufferPixels[pixelIndex], 1.f) };
+			const float green{ std::min(m_pColorBufferPixels[pixelCount + pixelIndex], 1.f) };
+			const float blue{ std::min(m_pColorBufferPixels[pixelCount * 2 + pixelIndex], 1.f) };
+			return 0.2126f * red + 0.7152f * green + 0.0722f * blue;
+		};
+
+	for (int blockMinY{ tileMinY }; blockMinY < tileMaxY; blockMinY += m_ShadingRateBlockSize)
+	{
+		for (int blockMinX{ tileMinX }; blockMinX < tileMaxX; blockMinX += m_ShadingRateBlockSize)
+		{
+			uint8_t& rate{ m_ShadingRates[(blockMinY / m_ShadingRateBlockSize) * m_ShadingRateBlockCountX + blockMinX / m_ShadingRateBlockSize] };
+
+			// Only the clear color there, nothing to lose
+			if (!m_TileCleared[tileIdx])
+			{
+				rate = m_CoarseShadingRateX | m_CoarseShadingRateY;
+				continue;
+			}
+
+			// Largest step to the right and downwards, each direction gets its own rate
+			// Measured over a coarse cell and halved, so a frame shaded at the coarse rate measures the same as one at full rate
+			// A step between neighbouring pixels would double in a coarse frame, and the block would flip rates every frame
+			const int blockMaxX{ std::min(blockMinX + m_ShadingRateBlockSize, tileMaxX) };
+			const int blockMaxY{ std::min(blockMinY + m_ShadingRateBlockSize, tileMaxY) };
+			float maxStepX{};
+			float maxStepY{};
+			for (int py{ blockMinY }; py < blockMaxY; ++py)
+			{
+				for (int px{ blockMinX }; px < blockMaxX; ++px)
+				{
+					const float luminance{ getLuminance(py * m_Width + px) };
+					if (px + m_CoarseCellSize < blockMaxX) maxStepX = std::max(maxStepX, std::abs(getLuminance(py * m_Width + px + m_CoarseCellSize) - luminance));
+					if (py + m_CoarseCellSize < blockMaxY) maxStepY = std::max(maxStepY, std::abs(getLuminance((py + m_CoarseCellSize) * m_Width + px) - luminance));
+				}
+			}
+			maxStepX /= m_CoarseCellSize;
+			maxStepY /= m_CoarseCellSize;
+
+			// Coarse directions only go back to full rate over a higher threshold
+			// A shade at the cell center samples the textures elsewhere than the pixels do, so the measured step still moves a little
+			const float thresholdX{ (rate & m_CoarseShadingRateX) != 0 ? m_ShadingRateLeaveThreshold : m_ShadingRateThreshold };
+			const float thresholdY{ (rate & m_CoarseShadingRateY) != 0 ? m_ShadingRateLeaveThreshold : m_ShadingRateThreshold };
+			rate = static_cast<uint8_t>((maxStepX < thresholdX ? m_CoarseShadingRateX : 0) | (maxStepY < thresholdY ? m_CoarseShadingRateY : 0));
+		}
+	}
+}
+
+template<SoftwareRenderer::DepthFormat format>
+uint32_t SoftwareRenderer::RasterizeTriangle(uint32_t triangleIdx, int minX, int minY, int maxX, int maxY)
+{
+	const TriangleSetup& triangle{ m_Triangles[triangleIdx] };
+
+	// If should show boundingBoxes, skip calculation
+	if (m_ShowBoundingBoxes)
+	{
+		const ColorRGB boundingBoxColor{ 1,1,1 };
+
+		for (int py{ minY }; py < maxY; ++py)
+		{
+			for (int px{ minX }; px < maxX; ++px)
+			{
+				if (m_UseMsaa) WriteSampleColors(py * m_Width + px, m_FullCoverageMask, boundingBoxColor);
+				else WriteColor(py * m_Width + px, boundingBoxColor);
+			}
+		}
+		return 0;
+	}
+
+	const EdgeFunction* edges{ triangle.edges };
+
+	// Conservative depth range, interpolation can land a few ulps outside the vertex depths
+	// Quantizing only ever rounds down, which keeps the lower bound conservative for the unorm formats
+	const float minZDepth{ QuantizeDepth<format>(triangle.minZDepth - std::abs(triangle.minZDepth) * m_HiZDepthMargin) };
+	const float maxZDepth{ triangle.maxZDepth + std::abs(triangle.maxZDepth) * m_HiZDepthMargin };
+
+	// Whole tile already in front of this triangle
+	const int tileIdx{ (minY / m_TileSize) * m_TileCountX + (minX / m_TileSize) };
+	if (minZDepth >= GetTileMaxDepth(tileIdx)) return 0;
+
+	// Coverage is already known, a few pixels don't need the block walk
+	if (triangle.isSmall)
+	{
+		return RasterizeStamp<format>(triangle, triangleIdx, tileIdx, minX, minY, maxX, maxY);
+	}
+
+	// Covers the whole tile in front of everything in it, only its plane needs to be kept
+	if (m_UseDepthCompression && !m_UseMsaa && IsCoveringTile(triangle, tileIdx, minX, minY, maxX, maxY) && maxZDepth < GetTileMinDepth(tileIdx))
+	{
+		return RasterizeCoveredTile(triangle, triangleIdx, tileIdx, minZDepth, maxZDepth);
+	}
+
+	// Multisampled, samples reach a bit past their pixel's center
+	const int64_t sampleReach{ m_UseMsaa ? m_MaxSampleOffset : 0 };
+
+	// Walk the range in HiZ blocks so occluded or empty blocks never reach the pixel loop
+	uint32_t depthPassedFragments{};
+	for (int blockMinY{ minY }; blockMinY < maxY; blockMinY = (blockMinY / m_HiZBlockSize + 1) * m_HiZBlockSize)
+	{
+		const int blockMaxY{ std::min((blockMinY / m_HiZBlockSize + 1) * m_HiZBlockSize, maxY) };
+
+		for (int blockMinX{ minX }; blockMinX < maxX; blockMinX = (blockMinX / m_HiZBlockSize + 1) * m_HiZBlockSize)
+		{
+			const int blockMaxX{ std::min((blockMinX / m_HiZBlockSize + 1) * m_HiZBlockSize, maxX) };
+
+			// Occluded, everything in the block is already closer
+			HiZBlock& block{ m_HiZBlocks[(blockMinY / m_HiZBlockSize) * m_HiZBlockCountX + (blockMinX / m_HiZBlockSize)] };
+			if (minZDepth >= block.maxDepth) continue;
+
+			// Outside, some edge is negative on every pixel center or sample of the block
+			bool isOutside{ false };
+			for (int edgeIdx{}; edgeIdx < 3 && !isOutside; ++edgeIdx)
+			{
+				const EdgeFunction& edge{ edges[edgeIdx] };
+				const int64_t cornerX{ static_cast<int64_t>(edge.a >= 0 ? blockMaxX - 1 : blockMinX) * m_SubPixelSteps + m_SubPixelSteps / 2 + (edge.a >= 0 ? sampleReach : -sampleReach) };
+				const int64_t cornerY{ static_cast<int64_t>(edge.b >= 0 ? blockMaxY - 1 : blockMinY) * m_SubPixelSteps + m_SubPixelSteps / 2 + (edge.b >= 0 ? sampleReach : -sampleReach) };
+
+				isOutside = edge.a * cornerX + edge.b * cornerY + edge.c < 0;
+			}
+			if (isOutside) continue;
+
+			// Still compressed, the pixel loop needs real depth values from here on
+			if (m_TileDepthStates[tileIdx] != TileDepthState::Expanded)
+			{
+				FillTileDepth<format>(tileIdx);
+			}
+
+			// Every covered pixel passes, skip reading the depth buffer
+			const bool passesDepthTest{ maxZDepth < block.minDepth };
+
+			const uint32_t blockFragments{ m_UseMsaa
+				? RasterizeBlockMsaa<format>(triangle, triangleIdx, blockMinX, blockMinY, blockMaxX, blockMaxY, passesDepthTest)
+				: RasterizeBlock<format>(triangle, triangleIdx, blockMinX, blockMinY, blockMaxX, blockMaxY, passesDepthTest) };
+			if (blockFragments > 0)
+			{
+				UpdateHiZBlock<format>(block, blockMinX, blockMinY);
+				depthPassedFragments += blockFragments;
+			}
+		}
+	}
+
+	if (depthPassedFragments > 0) m_HiZTileDirty[tileIdx] = true;
+
+	return depthPassedFragments;
+}
+
+bool SoftwareRenderer::IsCoveringTile(const TriangleSetup& triangle, int tileIdx, int minX, int minY, int maxX, int maxY) const
+{
+	// The range is already clipped to the tile, so it has to be the whole tile
+	int tileMinX{}, tileMinY{}, tileMaxX{}, tileMaxY{};
+	GetTileBounds(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+	if (minX != tileMinX || minY != tileMinY || maxX != tileMaxX || maxY != tileMaxY)
+	{
+		return false;
+	}
+
+	// Edges are linear, so the four corner pixel centers being inside means every pixel center is
+	for (const EdgeFunction& edge : triangle.edges)
+	{
+		for (int cornerIdx{}; cornerIdx < 4; ++cornerIdx)
+		{
+			const int64_t cornerX{ static_cast<int64_t>(cornerIdx & 1 ? maxX - 1 : minX) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+			const int64_t cornerY{ static_cast<int64_t>(cornerIdx & 2 ? maxY - 1 : minY) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+
+			if (edge.a * cornerX + edge.b * cornerY + edge.c < 0) return false;
+		}
+	}
+
+	return true;
+}
+
+uint32_t SoftwareRenderer::RasterizeCoveredTile(const TriangleSetup& triangle, uint32_t triangleIdx, int tileIdx, float minZDepth, float maxZDepth)
+{
+	// Tile pixel bounds
+	int tileMinX{}, tileMinY{}, tileMaxX{}, tileMaxY{};
+	GetTileBounds(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+
+	// Depth stays a plane until a later triangle needs the pixels
+	m_TileDepthStates[tileIdx] = TileDepthState::Planar;
+	m_TilePlanarTriangles[tileIdx] = triangleIdx;
+
+	// The triangle's range bounds every pixel in the tile
+	const int blockMinX{ tileMinX / m_HiZBlockSize };
+	const int blockMaxX{ (tileMaxX + m_HiZBlockSize - 1) / m_HiZBlockSize };
+	for (int blockY{ tileMinY / m_HiZBlockSize }; blockY < (tileMaxY + m_HiZBlockSize - 1) / m_HiZBlockSize; ++blockY)
+	{
+		std::fill(m_HiZBlocks.begin() + blockY * m_HiZBlockCountX + blockMinX, m_HiZBlocks.begin() + blockY * m_HiZBlockCountX + blockMaxX, HiZBlock{ minZDepth, maxZDepth });
+	}
+	m_HiZTileDirty[tileIdx] = true;
+
+	// Every pixel passes
+	for (int py{ tileMinY }; py < tileMaxY; ++py)
+	{
+		for (int px{ tileMinX }; px < tileMaxX; ++px)
+		{
+			if (m_IsCountingFragments) CountFragment(py * m_Width + px, true);
+
+			if (m_UseDeferredShading)
+			{
+				m_VisibilityTriangleIds[py * m_Width + px] = triangleIdx;
+				continue;
+			}
+
+			ShadePixel(triangle, px, py, triangle.zDepth.Evaluate(static_cast<float>(px - triangle.minX), static_cast<float>(py - triangle.minY)));
+		}
+	}
+
+	return static_cast<uint32_t>((tileMaxX - tileMinX) * (tileMaxY - tileMinY));
+}
+
+template<SoftwareRenderer::DepthFormat format>
+uint32_t SoftwareRenderer::RasterizeStamp(const TriangleSetup& triangle, uint32_t triangleIdx, int tileIdx, int minX, int minY, int maxX, int maxY)
+{
+	const int samplesPerPixel{ m_UseMsaa ? m_SampleCount : 1 };
+	const uint64_t pixelCoverageMask{ (uint64_t{ 1 } << samplesPerPixel) - 1 };
+	uint32_t depthPassedFragments{};
+
+	// The range is the part of the stamp inside this tile
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		for (int px{ minX }; px < maxX; ++px)
+		{
+			const int firstBit{ ((py - triangle.minY) * m_StampSize + (px - triangle.minX)) * samplesPerPixel };
+			const int coverageMask{ static_cast<int>((triangle.stampCoverage >> firstBit) & pixelCoverageMask) };
+			if (coverageMask == 0) continue;
+
+			// Still compressed, the depth test needs real values from here on
+			if (m_TileDepthStates[tileIdx] != TileDepthState::Expanded)
+			{
+				FillTileDepth<format>(tileIdx);
+			}
+
+			// Only the block's minimum follows incrementally, rebuilding all of its pixels would cost more than the stamp
+			// A maximum that is too large only culls less
+			HiZBlock& block{ m_HiZBlocks[(py / m_HiZBlockSize) * m_HiZBlockCountX + px / m_HiZBlockSize] };
+			const int pixelIndex{ py * m_Width + px };
+			const float dx{ static_cast<float>(px - triangle.minX) };
+			const float dy{ static_cast<float>(py - triangle.minY) };
+
+			if (m_UseMsaa)
+			{
+				// Depth test per covered sample, at the sample's own position on the depth plane
+				int passMask{};
+				for (int maskLeft{ coverageMask }; maskLeft != 0; maskLeft &= maskLeft - 1)
+				{
+					const int sampleIdx{ std::countr_zero(static_cast<uint32_t>(maskLeft)) };
+					const float sampleDx{ dx + static_cast<float>(m_SampleOffsetsX[sampleIdx]) / m_SubPixelSteps };
+					const float sampleDy{ dy + static_cast<float>(m_SampleOffsetsY[sampleIdx]) / m_SubPixelSteps };
+					const float depthKey{ QuantizeDepth<format>(triangle.zDepth.Evaluate(sampleDx, sampleDy)) };
+
+					const int sampleIndex{ pixelIndex * m_SampleCount + sampleIdx };
+					if (depthKey >= LoadDepth<format>(m_pSampleDepthPixels, sampleIndex)) continue;
+
+					StoreDepth<format>(m_pSampleDepthPixels, sampleIndex, depthKey);
+					block.minDepth = std::min(block.minDepth, depthKey);
+					passMask |= 1 << sampleIdx;
+				}
+				if (m_IsCountingFragments) CountFragment(pixelIndex, passMask != 0);
+				if (passMask == 0) continue;
+
+				++depthPassedFragments;
+
+				if (m_UseDeferredShading)
+				{
+					for (int maskLeft{ passMask }; maskLeft != 0; maskLeft &= maskLeft - 1)
+					{
+						m_VisibilityTriangleIds[pixelIndex * m_SampleCount + std::countr_zero(static_cast<uint32_t>(maskLeft))] = triangleIdx;
+					}
+					continue;
+				}
+
+				ShadeSamples(triangle, px, py, coverageMask, passMask);
+				continue;
+			}
+
+			const float interpolatedZDepth{ triangle.zDepth.Evaluate(dx, dy) };
+			const float depthKey{ QuantizeDepth<format>(interpolatedZDepth) };
+
+			const bool isCloserThenDepthBuffer{ depthKey < LoadDepth<format>(m_pDepthBufferPixels, pixelIndex) };
+			if (m_IsCountingFragments) CountFragment(pixelIndex, isCloserThenDepthBuffer);
+			if (!isCloserThenDepthBuffer) continue;
+
+			StoreDepth<format>(m_pDepthBufferPixels, pixelIndex, depthKey);
+			block.minDepth = std::min(block.minDepth, depthKey);
+			++depthPassedFragments;
+
+			if (m_UseDeferredShading)
+			{
+				m_VisibilityTriangleIds[pixelIndex] = triangleIdx;
+				continue;
+			}
+
+			ShadePixel(triangle, px, py, interpolatedZDepth);
+		}
+	}
+
+	return depthPassedFragments;
+}
+
+template<SoftwareRenderer::DepthFormat format>
+uint32_t SoftwareRenderer::RasterizeBlock(const TriangleSetup& triangle, uint32_t triangleIdx, int minX, int minY, int maxX, int maxY, bool passesDepthTest)
+{
+#if defined(__AVX2__)
+	if (m_UseSimd && !m_IsCountingFragments)
+	{
+		return RasterizeBlockSimd<format>(triangle, triangleIdx, minX, minY, maxX, maxY, passesDepthTest);
+	}
+#endif
+
+	const EdgeFunction* edges{ triangle.edges };
+	uint32_t depthPassedFragments{};
+
+	// Edge values at the center of the first pixel, every other pixel is one add away
+	const int64_t firstSampleX{ static_cast<int64_t>(minX) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+	const int64_t firstSampleY{ static_cast<int64_t>(minY) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+
+	int64_t rowEdgeValues[3]{};
+	for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+	{
+		rowEdgeValues[edgeIdx] = edges[edgeIdx].a * firstSampleX + edges[edgeIdx].b * firstSampleY + edges[edgeIdx].c;
+	}
+
+	// For every pixel
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		int64_t edgeValues[3]{ rowEdgeValues[0], rowEdgeValues[1], rowEdgeValues[2] };
+
+		for (int px{ minX }; px < maxX; ++px, edgeValues[0] += edges[0].stepX, edgeValues[1] += edges[1].stepX, edgeValues[2] += edges[2].stepX)
+		{
+			// Check if the pixel is in it, edge values already carry the top-left bias
+			const bool pixelInsideTriangleWeight{ (edgeValues[0] | edgeValues[1] | edgeValues[2]) >= 0 };
+			if (!pixelInsideTriangleWeight) continue;
+
+
+			///////////////////
+			// -- Z Depth -- //
+			///////////////////
+
+			const float interpolatedZDepth{ triangle.zDepth.Evaluate(static_cast<float>(px - triangle.minX), static_cast<float>(py - triangle.minY)) };
+			const float depthKey{ QuantizeDepth<format>(interpolatedZDepth) };
+
+			// Depth test
+			const int pixelIndex{ py * m_Width + px };
+			const bool isCloserThenDepthBuffer{ passesDepthTest || depthKey < LoadDepth<format>(m_pDepthBufferPixels, pixelIndex) };
+			if (m_IsCountingFragments) CountFragment(pixelIndex, isCloserThenDepthBuffer);
+			if (!isCloserThenDepthBuffer) continue;
+
+			StoreDepth<format>(m_pDepthBufferPixels, pixelIndex, depthKey);
+			++depthPassedFragments;
+
+			// Visibility buffer, shading waits for the resolve pass
+			if (m_UseDeferredShading)
+			{
+				m_VisibilityTriangleIds[pixelIndex] = triangleIdx;
+				continue;
+			}
+
+			ShadePixel(triangle, px, py, interpolatedZDepth);
+		}
+
+		for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+		{
+			rowEdgeValues[edgeIdx] += edges[edgeIdx].stepY;
+		}
+	}
+
+	return depthPassedFragments;
+}
+
+template<SoftwareRenderer::DepthFormat format>
+uint32_t SoftwareRenderer::RasterizeBlockMsaa(const TriangleSetup& triangle, uint32_t triangleIdx, int minX, int minY, int maxX, int maxY, bool passesDepthTest)
+{
+#if defined(__AVX2__)
+	if (m_UseSimd && !m_IsCountingFragments)
+	{
+		return RasterizeBlockMsaaSimd<format>(triangle, triangleIdx, minX, minY, maxX, maxY, passesDepthTest);
+	}
+#endif
+
+	const EdgeFunction* edges{ triangle.edges };
+	uint32_t depthPassedFragments{};
+
+	// Edge values at the center of the first pixel, every sample is a fixed offset away from its pixel's center
+	const int64_t firstSampleX{ static_cast<int64_t>(minX) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+	const int64_t firstSampleY{ static_cast<int64_t>(minY) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+
+	int64_t rowEdgeValues[3]{};
+	int64_t sampleEdgeOffsets[3][m_SampleCount]{};
+	for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+	{
+		const EdgeFunction& edge{ edges[edgeIdx] };
+		rowEdgeValues[edgeIdx] = edge.a * firstSampleX + edge.b * firstSampleY + edge.c;
+
+		for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+		{
+			sampleEdgeOffsets[edgeIdx][sampleIdx] = edge.a * m_SampleOffsetsX[sampleIdx] + edge.b * m_SampleOffsetsY[sampleIdx];
+		}
+	}
+
+	// For every pixel
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		int64_t edgeValues[3]{ rowEdgeValues[0], rowEdgeValues[1], rowEdgeValues[2] };
+
+		for (int px{ minX }; px < maxX; ++px, edgeValues[0] += edges[0].stepX, edgeValues[1] += edges[1].stepX, edgeValues[2] += edges[2].stepX)
+		{
+			// Coverage per sample, edge values already carry the top-left bias
+			int coverageMask{};
+			for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+			{
+				const bool isSampleInside{ ((edgeValues[0] + sampleEdgeOffsets[0][sampleIdx]) | (edgeValues[1] + sampleEdgeOffsets[1][sampleIdx]) | (edgeValues[2] + sampleEdgeOffsets[2][sampleIdx])) >= 0 };
+				coverageMask |= static_cast<int>(isSampleInside) << sampleIdx;
+			}
+			if (coverageMask == 0) continue;
+
+
+			///////////////////
+			// -- Z Depth -- //
+			///////////////////
+
+			// Depth test per covered sample, at the sample's own position on the depth plane
+			const int pixelIndex{ py * m_Width + px };
+			const float dx{ static_cast<float>(px - triangle.minX) };
+			const float dy{ static_cast<float>(py - triangle.minY) };
+
+			int passMask{};
+			for (int maskLeft{ coverageMask }; maskLeft != 0; maskLeft &= maskLeft - 1)
+			{
+				const int sampleIdx{ std::countr_zero(static_cast<uint32_t>(maskLeft)) };
+				const float sampleDx{ dx + static_cast<float>(m_SampleOffsetsX[sampleIdx]) / m_SubPixelSteps };
+				const float sampleDy{ dy + static_cast<float>(m_SampleOffsetsY[sampleIdx]) / m_SubPixelSteps };
+				const float depthKey{ QuantizeDepth<format>(triangle.zDepth.Evaluate(sampleDx, sampleDy)) };
+
+				const int sampleIndex{ pixelIndex * m_SampleCount + sampleIdx };
+				if (!passesDepthTest && depthKey >= LoadDepth<format>(m_pSampleDepthPixels, sampleIndex)) continue;
+
+				StoreDepth<format>(m_pSampleDepthPixels, sampleIndex, depthKey);
+				passMask |= 1 << sampleIdx;
+			}
+			if (m_IsCountingFragments) CountFragment(pixelIndex, passMask != 0);
+			if (passMask == 0) continue;
+
+			// Fragments are counted per pixel, they get shaded once no matter how many samples passed
+			++depthPassedFragments;
+
+			// Visibility buffer, one id per sample
+			if (m_UseDeferredShading)
+			{
+				for (int maskLeft{ passMask }; maskLeft != 0; maskLeft &= maskLeft - 1)
+				{
+					m_VisibilityTriangleIds[pixelIndex * m_SampleCount + std::countr_zero(static_cast<uint32_t>(maskLeft))] = triangleIdx;
+				}
+				continue;
+			}
+
+			ShadeSamples(triangle, px, py, coverageMask, passMask);
+		}
+
+		for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+		{
+			rowEdgeValues[edgeIdx] += edges[edgeIdx].stepY;
+		}
+	}
+
+	return depthPassedFragments;
+}
+
+#if defined(__AVX2__)
+template<SoftwareRenderer::DepthFormat format>
+uint32_t SoftwareRenderer::RasterizeBlockSimd(const TriangleSetup& triangle, uint32_t triangleIdx, int minX, int minY, int maxX, int maxY, bool passesDepthTest)
+{
+	// Same math as the scalar loop, 8 horizontally adjacent pixels at a time
+	// Edge values need 64 bits, so every edge is kept as two halves of 4 lanes
+	const EdgeFunction* edges{ triangle.edges };
+
+	const int64_t firstSampleX{ static_cast<int64_t>(minX) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+	const int64_t firstSampleY{ static_cast<int64_t>(minY) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+
+	int64_t rowEdgeValues[3]{};
+	__m256i laneOffsetsLow[3]{};
+	__m256i laneOffsetsHigh[3]{};
+	__m256i groupSteps[3]{};
+	for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+	{
+		const EdgeFunction& edge{ edges[edgeIdx] };
+		rowEdgeValues[edgeIdx] = edge.a * firstSampleX + edge.b * firstSampleY + edge.c;
+
+		laneOffsetsLow[edgeIdx] = _mm256_setr_epi64x(0, edge.stepX, edge.stepX * 2, edge.stepX * 3);
+		laneOffsetsHigh[edgeIdx] = _mm256_setr_epi64x(edge.stepX * 4, edge.stepX * 5, edge.stepX * 6, edge.stepX * 7);
+		groupSteps[edgeIdx] = _mm256_set1_epi64x(edge.stepX * 8);
+	}
+
+	const __m256 zDepthStepX{ _mm256_set1_ps(triangle.zDepth.a) };
+	const __m256i laneIndices{ _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) };
+	const __m256 laneOffsets{ _mm256_cvtepi32_ps(laneIndices) };
+
+	alignas(32) float zDepths[8]{};
+
+	uint32_t depthPassedFragments{};
+
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		__m256i edgeValuesLow[3]{};
+		__m256i edgeValuesHigh[3]{};
+		for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+		{
+			const __m256i rowValue{ _mm256_set1_epi64x(rowEdgeValues[edgeIdx]) };
+			edgeValuesLow[edgeIdx] = _mm256_add_epi64(rowValue, laneOffsetsLow[edgeIdx]);
+			edgeValuesHigh[edgeIdx] = _mm256_add_epi64(rowValue, laneOffsetsHigh[edgeIdx]);
+		}
+
+		// Depth plane with the row part folded in, same evaluation order as AttributePlane::Evaluate
+		const __m256 rowZDepth{ _mm256_set1_ps(triangle.zDepth.c + triangle.zDepth.b * static_cast<float>(py - triangle.minY)) };
+
+		for (int px{ minX }; px < maxX; px += 8)
+		{
+			// Coverage, sign bit of the OR is set when any edge is negative
+			const __m256i outsideLow{ _mm256_or_si256(_mm256_or_si256(edgeValuesLow[0], edgeValuesLow[1]), edgeValuesLow[2]) };
+			const __m256i outsideHigh{ _mm256_or_si256(_mm256_or_si256(edgeValuesHigh[0], edgeValuesHigh[1]), edgeValuesHigh[2]) };
+			const int outsideMask{ _mm256_movemask_pd(_mm256_castsi256_pd(outsideLow)) | (_mm256_movemask_pd(_mm256_castsi256_pd(outsideHigh)) << 4) };
+
+			// Lanes past the end of the range
+			const int laneCount{ std::min(maxX - px, 8) };
+			const __m256i inRange{ _mm256_cmpgt_epi32(_mm256_set1_epi32(laneCount), laneIndices) };
+			const int coverageMask{ ~outsideMask & _mm256_movemask_ps(_mm256_castsi256_ps(inRange)) };
+
+			if (coverageMask != 0)
+			{
+				// Z Depth
+				const __m256 dx{ _mm256_add_ps(_mm256_set1_ps(static_cast<float>(px - triangle.minX)), laneOffsets) };
+				const __m256 interpolatedZDepth{ _mm256_add_ps(rowZDepth, _mm256_mul_ps(zDepthStepX, dx)) };
+				const __m256 depthKey{ QuantizeDepthSimd<format>(interpolatedZDepth) };
+
+				// Depth test, only touching lanes inside the range
+				const int pixelIndex{ py * m_Width + px };
+				int passMask{ coverageMask };
+				if (!passesDepthTest)
+				{
+					const __m256 depthBuffer{ LoadDepthSimd<format>(m_pDepthBufferPixels, pixelIndex, inRange, laneCount) };
+					const __m256 closer{ _mm256_cmp_ps(depthKey, depthBuffer, _CMP_LT_OQ) };
+					passMask &= _mm256_movemask_ps(closer);
+				}
+
+				if (passMask != 0)
+				{
+					depthPassedFragments += std::popcount(static_cast<uint32_t>(passMask));
+
+					// Masked depth write
+					const __m256i passLanes{ _mm256_cmpgt_epi32(_mm256_and_si256(_mm256_set1_epi32(passMask), _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)), _mm256_setzero_si256()) };
+					StoreDepthSimd<format>(m_pDepthBufferPixels, pixelIndex, passLanes, passMask, laneCount, depthKey);
+
+					// Visibility buffer, same masked write for the id
+					if (m_UseDeferredShading)
+					{
+						_mm256_maskstore_epi32(reinterpret_cast<int*>(m_VisibilityTriangleIds.data() + pixelIndex), passLanes, _mm256_set1_epi32(static_cast<int>(triangleIdx)));
+					}
+					else
+					{
+						_mm256_store_ps(zDepths, interpolatedZDepth);
+
+						// Shade the surviving lanes one by one
+						for (int laneMaskLeft{ passMask }; laneMaskLeft != 0; laneMaskLeft &= laneMaskLeft - 1)
+						{
+							const int lane{ std::countr_zero(static_cast<uint32_t>(laneMaskLeft)) };
+							ShadePixel(triangle, px + lane, py, zDepths[lane]);
+						}
+					}
+				}
+			}
+
+			for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+			{
+				edgeValuesLow[edgeIdx] = _mm256_add_epi64(edgeValuesLow[edgeIdx], groupSteps[edgeIdx]);
+				edgeValuesHigh[edgeIdx] = _mm256_add_epi64(edgeValuesHigh[edgeIdx], groupSteps[edgeIdx]);
+			}
+		}
+
+		for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+		{
+			rowEdgeValues[edgeIdx] += edges[edgeIdx].stepY;
+		}
+	}
+
+	return depthPassedFragments;
+}
+
+template<SoftwareRenderer::DepthFormat format>
+uint32_t SoftwareRenderer::RasterizeBlockMsaaSimd(const TriangleSetup& triangle, uint32_t triangleIdx, int minX, int minY, int maxX, int maxY, bool passesDepthTest)
+{
+	// Same math as the scalar loop, the 4 samples of 2 horizontally adjacent pixels at a time
+	// Samples of a pixel are adjacent in the sample buffers, so the 8 lanes are one contiguous load and store
+	const EdgeFunction* edges{ triangle.edges };
+
+	const int64_t firstSampleX{ static_cast<int64_t>(minX) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+	const int64_t firstSampleY{ static_cast<int64_t>(minY) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+
+	int64_t rowEdgeValues[3]{};
+	__m256i laneOffsetsLow[3]{};
+	__m256i laneOffsetsHigh[3]{};
+	__m256i pairSteps[3]{};
+	for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+	{
+		const EdgeFunction& edge{ edges[edgeIdx] };
+		rowEdgeValues[edgeIdx] = edge.a * firstSampleX + edge.b * firstSampleY + edge.c;
+
+		int64_t sampleEdgeOffsets[m_SampleCount]{};
+		for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+		{
+			sampleEdgeOffsets[sampleIdx] = edge.a * m_SampleOffsetsX[sampleIdx] + edge.b * m_SampleOffsetsY[sampleIdx];
+		}
+
+		laneOffsetsLow[edgeIdx] = _mm256_setr_epi64x(sampleEdgeOffsets[0], sampleEdgeOffsets[1], sampleEdgeOffsets[2], sampleEdgeOffsets[3]);
+		laneOffsetsHigh[edgeIdx] = _mm256_add_epi64(laneOffsetsLow[edgeIdx], _mm256_set1_epi64x(edge.stepX));
+		pairSteps[edgeIdx] = _mm256_set1_epi64x(edge.stepX * 2);
+	}
+
+	// Sample positions relative to the first pixel's center, exact in float
+	float laneOffsetsX[8]{};
+	float laneOffsetsY[8]{};
+	for (int lane{}; lane < 8; ++lane)
+	{
+		laneOffsetsX[lane] = static_cast<float>(lane / m_SampleCount) + static_cast<float>(m_SampleOffsetsX[lane % m_SampleCount]) / m_SubPixelSteps;
+		laneOffsetsY[lane] = static_cast<float>(m_SampleOffsetsY[lane % m_SampleCount]) / m_SubPixelSteps;
+	}
+	const __m256 sampleDx{ _mm256_loadu_ps(laneOffsetsX) };
+	const __m256 sampleDy{ _mm256_loadu_ps(laneOffsetsY) };
+	const __m256 zDepthStepX{ _mm256_set1_ps(triangle.zDepth.a) };
+	const __m256 zDepthStepY{ _mm256_set1_ps(triangle.zDepth.b) };
+	const __m256 zDepthOrigin{ _mm256_set1_ps(triangle.zDepth.c) };
+	const __m256i laneBits{ _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128) };
+
+	uint32_t depthPassedFragments{};
+
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		__m256i edgeValuesLow[3]{};
+		__m256i edgeValuesHigh[3]{};
+		for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+		{
+			const __m256i rowValue{ _mm256_set1_epi64x(rowEdgeValues[edgeIdx]) };
+			edgeValuesLow[edgeIdx] = _mm256_add_epi64(rowValue, laneOffsetsLow[edgeIdx]);
+			edgeValuesHigh[edgeIdx] = _mm256_add_epi64(rowValue, laneOffsetsHigh[edgeIdx]);
+		}
+
+		// Depth plane with the row part folded in, same evaluation order as AttributePlane::Evaluate
+		const __m256 rowDy{ _mm256_add_ps(_mm256_set1_ps(static_cast<float>(py - triangle.minY)), sampleDy) };
+		const __m256 rowZDepth{ _mm256_add_ps(zDepthOrigin, _mm256_mul_ps(zDepthStepY, rowDy)) };
+
+		for (int px{ minX }; px < maxX; px += 2)
+		{
+			// Coverage, low half holds the first pixel's samples, high half the second's
+			const __m256i outsideLow{ _mm256_or_si256(_mm256_or_si256(edgeValuesLow[0], edgeValuesLow[1]), edgeValuesLow[2]) };
+			const __m256i outsideHigh{ _mm256_or_si256(_mm256_or_si256(edgeValuesHigh[0], edgeValuesHigh[1]), edgeValuesHigh[2]) };
+			const int outsideMask{ _mm256_movemask_pd(_mm256_castsi256_pd(outsideLow)) | (_mm256_movemask_pd(_mm256_castsi256_pd(outsideHigh)) << 4) };
+
+			// Second pixel past the end of the range
+			const int laneCount{ std::min(maxX - px, 2) * m_SampleCount };
+			const __m256i inRange{ _mm256_cmpgt_epi32(_mm256_set1_epi32(laneCount), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)) };
+			const int coverageMask{ ~outsideMask & _mm256_movemask_ps(_mm256_castsi256_ps(inRange)) };
+
+			if (coverageMask != 0)
+			{
+				// Z Depth
+				const __m256 dx{ _mm256_add_ps(_mm256_set1_ps(static_cast<float>(px - triangle.minX)), sampleDx) };
+				const __m256 depthKey{ QuantizeDepthSimd<format>(_mm256_add_ps(rowZDepth, _mm256_mul_ps(zDepthStepX, dx))) };
+
+				// Depth test, only touching lanes inside the range
+				const int firstSampleIndex{ (py * m_Width + px) * m_SampleCount };
+				int passMask{ coverageMask };
+				if (!passesDepthTest)
+				{
+					const __m256 depthBuffer{ LoadDepthSimd<format>(m_pSampleDepthPixels, firstSampleIndex, inRange, laneCount) };
+					passMask &= _mm256_movemask_ps(_mm256_cmp_ps(depthKey, depthBuffer, _CMP_LT_OQ));
+				}
+
+				if (passMask != 0)
+				{
+					// Masked depth write
+					const __m256i passLanes{ _mm256_cmpgt_epi32(_mm256_and_si256(_mm256_set1_epi32(passMask), laneBits), _mm256_setzero_si256()) };
+					StoreDepthSimd<format>(m_pSampleDepthPixels, firstSampleIndex, passLanes, passMask, laneCount, depthKey);
+
+					// Visibility buffer, same masked write for the ids
+					if (m_UseDeferredShading)
+					{
+						_mm256_maskstore_epi32(reinterpret_cast<int*>(m_VisibilityTriangleIds.data() + firstSampleIndex), passLanes, _mm256_set1_epi32(static_cast<int>(triangleIdx)));
+					}
+
+					// Fragments are counted and shaded per pixel
+					for (int pixelIdx{}; pixelIdx < 2; ++pixelIdx)
+					{
+						const int pixelPassMask{ (passMask >> (pixelIdx * m_SampleCount)) & m_FullCoverageMask };
+						if (pixelPassMask == 0) continue;
+
+						++depthPassedFragments;
+						if (m_UseDeferredShading) continue;
+
+						ShadeSamples(triangle, px + pixelIdx, py, (coverageMask >> (pixelIdx * m_SampleCount)) & m_FullCoverageMask, pixelPassMask);
+					}
+				}
+			}
+
+			for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+			{
+				edgeValuesLow[edgeIdx] = _mm256_add_epi64(edgeValuesLow[edgeIdx], pairSteps[edgeIdx]);
+				edgeValuesHigh[edgeIdx] = _mm256_add_epi64(edgeValuesHigh[edgeIdx], pairSteps[edgeIdx]);
+			}
+		}
+
+		for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+		{
+			rowEdgeValues[edgeIdx] += edges[edgeIdx].stepY;
+		}
+	}
+
+	return depthPassedFragments;
+}
+
+template<SoftwareRenderer::DepthFormat format>
+__m256 SoftwareRenderer::QuantizeDepthSimd(__m256 depthKey)
+{
+	if constexpr (format == DepthFormat::Unorm24 || format == DepthFormat::Unorm16)
+	{
+		// Same clamp and truncation as the scalar version
+		const __m256 clampedKey{ _mm256_min_ps(_mm256_max_ps(depthKey, _mm256_setzero_ps()), _mm256_set1_ps(GetDepthScale<format>())) };
+		return _mm256_cvtepi32_ps(_mm256_cvttps_epi32(clampedKey));
+	}
+	else
+	{
+		return depthKey;
+	}
+}
+
+template<SoftwareRenderer::DepthFormat format>
+__m256 SoftwareRenderer::LoadDepthSimd(const std::byte* pDepthBuffer, int depthIndex, __m256i inRange, int laneCount)
+{
+	if constexpr (format == DepthFormat::Unorm16)
+	{
+		// No masked 16-bit loads, partial groups go through a copy so nothing past the range is read
+		const uint16_t* pDepth{ reinterpret_cast<const uint16_t*>(pDepthBuffer) + depthIndex };
+		__m128i depthValues{};
+		if (laneCount == 8)
+		{
+			depthValues = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pDepth));
+		}
+		else
+		{
+			alignas(16) uint16_t laneValues[8]{};
+			std::memcpy(laneValues, pDepth, laneCount * sizeof(uint16_t));
+			depthValues = _mm_load_si128(reinterpret_cast<const __m128i*>(laneValues));
+		}
+		return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(depthValues));
+	}
+	else if constexpr (format == DepthFormat::Unorm24)
+	{
+		return _mm256_cvtepi32_ps(_mm256_maskload_epi32(reinterpret_cast<const int*>(pDepthBuffer) + depthIndex, inRange));
+	}
+	else
+	{
+		return _mm256_maskload_ps(reinterpret_cast<const float*>(pDepthBuffer) + depthIndex, inRange);
+	}
+}
+
+template<SoftwareRenderer::DepthFormat format>
+void SoftwareRenderer::StoreDepthSimd(std::byte* pDepthBuffer, int depthIndex, __m256i passLanes, int passMask, int laneCount, __m256 depthKey)
+{
+	if constexpr (format == DepthFormat::Unorm16)
+	{
+		// A full group stays inside the tile, so a blended read-modify-write can't race another thread
+		uint16_t* pDepth{ reinterpret_cast<uint16_t*>(pDepthBuffer) + depthIndex };
+		if (laneCount == 8)
+		{
+			const __m256i depthValues{ _mm256_cvttps_epi32(depthKey) };
+			const __m128i packedValues{ _mm_packus_epi32(_mm256_castsi256_si128(depthValues), _mm256_extracti128_si256(depthValues, 1)) };
+			const __m128i packedLanes{ _mm_packs_epi32(_mm256_castsi256_si128(passLanes), _mm256_extracti128_si256(passLanes, 1)) };
+			const __m128i oldValues{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pDepth)) };
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDepth), _mm_blendv_epi8(oldValues, packedValues, packedLanes));
+		}
+		else
+		{
+			alignas(32) float laneKeys[8]{};
+			_mm256_store_ps(laneKeys, depthKey);
+			for (int laneMaskLeft{ passMask }; laneMaskLeft != 0; laneMaskLeft &= laneMaskLeft - 1)
+			{
+				const int lane{ std::countr_zero(static_cast<uint32_t>(laneMaskLeft)) };
+				StoreDepth<format>(pDepthBuffer, depthIndex + lane, laneKeys[lane]);
+			}
+		}
+	}
+	else if constexpr (format == DepthFormat::Unorm24)
+	{
+		_mm256_maskstore_epi32(reinterpret_cast<int*>(pDepthBuffer) + depthIndex, passLanes, _mm256_cvttps_epi32(depthKey));
+	}
+	else
+	{
+		_mm256_maskstore_ps(reinterpret_cast<float*>(pDepthBuffer) + depthIndex, passLanes, depthKey);
+	}
+}
+#endif
+
+template<SoftwareRenderer::DepthFormat format>
+float SoftwareRenderer::QuantizeDepth(float depthKey)
+{
+	// Truncate to the stored integer, rounding down keeps HiZ bounds conservative
+	if constexpr (format == DepthFormat::Unorm24 || format == DepthFormat::Unorm16)
+	{
+		return static_cast<float>(static_cast<int32_t>(std::min(std::max(depthKey, 0.f), GetDepthScale<format>())));
+	}
+	else
+	{
+		return depthKey;
+	}
+}
+
+template<SoftwareRenderer::DepthFormat format>
+float SoftwareRenderer::LoadDepth(const std::byte* pDepthBuffer, int depthIndex)
+{
+	DepthStorage<format> depthValue{};
+	std::memcpy(&depthValue, pDepthBuffer + depthIndex * sizeof(depthValue), sizeof(depthValue));
+	return static_cast<float>(depthValue);
+}
+
+template<SoftwareRenderer::DepthFormat format>
+void SoftwareRenderer::StoreDepth(std::byte* pDepthBuffer, int depthIndex, float depthKey)
+{
+	// Keys are already quantized, the conversion is exact
+	const DepthStorage<format> depthValue{ static_cast<DepthStorage<format>>(depthKey) };
+	std::memcpy(pDepthBuffer + depthIndex * sizeof(depthValue), &depthValue, sizeof(depthValue));
+}
+
+template<SoftwareRenderer::DepthFormat format>
+void SoftwareRenderer::UpdateHiZBlock(HiZBlock& block, int blockMinX, int blockMinY)
+{
+	// Depth only ever shrinks, rebuild the range from the pixels that are on screen
+	const int blockStartX{ (blockMinX / m_HiZBlockSize) * m_HiZBlockSize };
+	const int blockStartY{ (blockMinY / m_HiZBlockSize) * m_HiZBlockSize };
+	const int blockEndX{ std::min(blockStartX + m_HiZBlockSize, m_Width) };
+	const int blockEndY{ std::min(blockStartY + m_HiZBlockSize, m_Height) };
+
+	// Multisampled, every sample of a pixel counts
+	const std::byte* pDepthBuffer{ m_UseMsaa ? m_pSampleDepthPixels : m_pDepthBufferPixels };
+	const int depthsPerPixel{ m_UseMsaa ? m_SampleCount : 1 };
+
+	float minDepth{ FLT_MAX };
+	float maxDepth{ -FLT_MAX };
+	for (int py{ blockStartY }; py < blockEndY; ++py)
+	{
+		for (int depthIndex{ (py * m_Width + blockStartX) * depthsPerPixel }; depthIndex < (py * m_Width + blockEndX) * depthsPerPixel; ++depthIndex)
+		{
+			const float depth{ LoadDepth<format>(pDepthBuffer, depthIndex) };
+			minDepth = std::min(minDepth, depth);
+			maxDepth = std::max(maxDepth, depth);
+		}
+	}
+
+	block.minDepth = minDepth;
+	block.maxDepth = maxDepth;
+}
+
+float SoftwareRenderer::GetTileMaxDepth(int tileIdx)
+{
+	// Tile level of the pyramid, only rebuilt after a triangle wrote depth in the tile
+	if (m_HiZTileDirty[tileIdx])
+	{
+		const int blockStartX{ (tileIdx % m_TileCountX) * (m_TileSize / m_HiZBlockSize) };
+		const int blockStartY{ (tileIdx / m_TileCountX) * (m_TileSize / m_HiZBlockSize) };
+		const int blockEndX{ std::min(blockStartX + m_TileSize / m_HiZBlockSize, m_HiZBlockCountX) };
+		const int blockEndY{ std::min(blockStartY + m_TileSize / m_HiZBlockSize, m_HiZBlockCountY) };
+
+		float maxDepth{ -FLT_MAX };
+		for (int blockY{ blockStartY }; blockY < blockEndY; ++blockY)
+		{
+			for (int blockX{ blockStartX }; blockX < blockEndX; ++blockX)
+			{
+				maxDepth = std::max(maxDepth, m_HiZBlocks[blockY * m_HiZBlockCountX + blockX].maxDepth);
+			}
+		}
+
+		m_HiZTileMaxDepths[tileIdx] = maxDepth;
+		m_HiZTileDirty[tileIdx] = false;
+	}
+
+	return m_HiZTileMaxDepths[tileIdx];
+}
+
+float SoftwareRenderer::GetTileMinDepth(int tileIdx) const
+{
+	// Only needed for the rare triangle covering a whole tile, so not cached
+	const int blockStartX{ (tileIdx % m_TileCountX) * (m_TileSize / m_HiZBlockSize) };
+	const int blockStartY{ (tileIdx / m_TileCountX) * (m_TileSize / m_HiZBlockSize) };
+	const int blockEndX{ std::min(blockStartX + m_TileSize / m_HiZBlockSize, m_HiZBlockCountX) };
+	const int blockEndY{ std::min(blockStartY + m_TileSize / m_HiZBlockSize, m_HiZBlockCountY) };
+
+	float minDepth{ FLT_MAX };
+	for (int blockY{ blockStartY }; blockY < blockEndY; ++blockY)
+	{
+		for (int blockX{ blockStartX }; blockX < blockEndX; ++blockX)
+		{
+			minDepth = std::min(minDepth, m_HiZBlocks[blockY * m_HiZBlockCountX + blockX].minDepth);
+		}
+	}
+
+	return minDepth;
+}
+
+void SoftwareRenderer::ShadePixel(const TriangleSetup& triangle, int px, int py, float depthKey)
+{
+	// Pixel center relative to the planes' origin
+	const float dx{ static_cast<float>(px - triangle.minX) };
+	const float dy{ static_cast<float>(py - triangle.minY) };
+
+	//Update Color in Buffer, the resolve pass takes care of the range and pixel format
+	WriteColor(px + (py * m_Width), ShadeFragment(triangle, dx, dy, depthKey));
+}
+
+ColorRGB SoftwareRenderer::ShadeFragment(const TriangleSetup& triangle, float dx, float dy, float depthKey) const
+{
+	// Depth formats store their own key, shading wants z/w
+	const float interpolatedZDepth{ DecodeDepth(depthKey) };
+
+	// W Depth, for perspective correct attributes
+	const float interpolatedWDepth{ 1 / triangle.inverseWDepth.Evaluate(dx, dy) };
+
+	//////////////
+	// -- UV -- //
+	//////////////
+
+	const Vector2 interpolatedUV{ Vector2{ triangle.uv[0].Evaluate(dx, dy), triangle.uv[1].Evaluate(dx, dy) } * interpolatedWDepth };
+	const ColorRGB uvColor{ m_pDiffuseTexture->Sample(interpolatedUV) };
+
+
+	///////////////////
+	// -- Shading -- //
+	///////////////////
+
+	Vector3 desiredNormal{};
+
+	// Interpolate Normal
+	const Vector3 interpolatedNormal{ Vector3{ triangle.normal[0].Evaluate(dx, dy), triangle.normal[1].Evaluate(dx, dy), triangle.normal[2].Evaluate(dx, dy) } * interpolatedWDepth };
+	desiredNormal = interpolatedNormal;
+
+	// Interpolate Tangent
+	const Vector3 interpolatedTangent{ Vector3{ triangle.tangent[0].Evaluate(dx, dy), triangle.tangent[1].Evaluate(dx, dy), triangle.tangent[2].Evaluate(dx, dy) } * interpolatedWDepth };
+
+	// Tangent space transformation matrix
+	if (m_UseNormalMap)
+	{
+		// Sample normal
+		const ColorRGB normalColor{ m_pNormalTexture->Sample(interpolatedUV) };
+		Vector3 sampledNormal{ normalColor.r, normalColor.g, normalColor.b };
+		sampledNormal = 2.f * sampledNormal - Vector3{ 1.f, 1.f, 1.f };
+
+		// Create tangentSpaceAxis
+		const Vector3 binormal{ Vector3::Cross(interpolatedNormal,interpolatedTangent) };
+		Matrix tangentSpaceAxis{};
+
+		tangentSpaceAxis[0] = { interpolatedTangent, 0 };
+		tangentSpaceAxis[1] = { binormal,0 };
+		tangentSpaceAxis[2] = { interpolatedNormal,0 };
+		tangentSpaceAxis[3] = { 0,0,0,0 };
+
+		// Multiply sampledNormal with matrix
+		desiredNormal = tangentSpaceAxis.TransformVector(sampledNormal);
+	}
+
+	// Interpolate viewDirection, vertex directions got normalized in triangle setup
+	const Vector3 interpolatedViewDirection{ Vector3{ triangle.viewDirection[0].Evaluate(dx, dy), triangle.viewDirection[1].Evaluate(dx, dy), triangle.viewDirection[2].Evaluate(dx, dy) } * interpolatedWDepth };
+
+	// Collecting all interpolations
+	VS_OUPUT shadingVertex{};
+	shadingVertex.Position = Vector4{ static_cast<float>(triangle.minX) + dx + 0.5f,static_cast<float>(triangle.minY) + dy + 0.5f,interpolatedZDepth,interpolatedWDepth };
+	shadingVertex.Color = uvColor;
+	shadingVertex.UV = interpolatedUV;
+	shadingVertex.normal = desiredNormal;
+	shadingVertex.tangent = interpolatedTangent;
+	shadingVertex.viewDirection = interpolatedViewDirection;
+
+	// Actual shading
+	const ColorRGB shadedColor{ PixelShading(shadingVertex) };
+
+
+	//////////////////////
+	// -- Show Color -- //
+	//////////////////////
+
+	// Switch between showing finalColor and depthBuffer
+	ColorRGB finalColor{};
+	if (!m_ShowDepthBuffer)
+	{
+		finalColor = shadedColor;
+	}
+	else
+	{
+		const float remapValue{ InverseLerp(.985f,1.f,interpolatedZDepth) };
+		const ColorRGB depthBufferColor{ remapValue, remapValue, remapValue };
+
+		finalColor = depthBufferColor;
+	}
+
+	return finalColor;
+}
+
+void SoftwareRenderer::WriteColor(int pixelIndex, const ColorRGB& color)
+{
+	const int pixelCount{ m_Width * m_Height };
+	m_pColorBufferPixels[pixelIndex] = color.r;
+	m_pColorBufferPixels[pixelCount + pixelIndex] = color.g;
+	m_pColorBufferPixels[pixelCount * 2 + pixelIndex] = color.b;
+}
+
+int SoftwareRenderer::GetCoverageMask(const TriangleSetup& triangle, int px, int py) const
+{
+	const int64_t centerX{ static_cast<int64_t>(px) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+	const int64_t centerY{ static_cast<int64_t>(py) * m_SubPixelSteps + m_SubPixelSteps / 2 };
+
+	int coverageMask{};
+	for (int sampleIdx{}; sampleIdx < m_SampleCount; ++sampleIdx)
+	{
+		bool isSampleInside{ true };
+		for (const EdgeFunction& edge : triangle.edges)
+		{
+			isSampleInside &= edge.a * (centerX + m_SampleOffsetsX[sampleIdx]) + edge.b * (centerY + m_SampleOffsetsY[sampleIdx]) + edge.c >= 0;
+		}
+		coverageMask |= static_cast<int>(isSampleInside) << sampleIdx;
+	}
+
+	return coverageMask;
+}
+
+void SoftwareRenderer::ShadeSamples(const TriangleSetup& triangle, int px, int py, int coverageMask, int sampleMask)
+{
+	// Pixel center when the triangle covers all samples, else the centroid of the covered ones
+	// The centroid is always inside the triangle, so edge pixels never extrapolate attributes past the texture
+	float dx{ static_cast<float>(px - triangle.minX) };
+	float dy{ static_cast<float>(py - triangle.minY) };
+	if (coverageMask != m_FullCoverageMask)
+	{
+		int offsetX{};
+		int offsetY{};
+		for (int maskLeft{ coverageMask }; maskLeft != 0; maskLeft &= maskLeft - 1)
+		{
+			const int sampleIdx{ std::countr_zero(static_cast<uint32_t>(maskLeft)) };
+			offsetX += m_SampleOffsetsX[sampleIdx];
+			offsetY += m_SampleOffsetsY[sampleIdx];
+		}
+
+		const float coveredSteps{ static_cast<float>(std::popcount(static_cast<uint32_t>(coverageMask)) * m_SubPixelSteps) };
+		dx += static_cast<float>(offsetX) / coveredSteps;
+		dy += static_cast<float>(offsetY) / coveredSteps;
+	}
+
+	WriteSampleColors(py * m_Width + px, sampleMask, ShadeFragment(triangle, dx, dy, triangle.zDepth.Evaluate(dx, dy)));
+}
+
+void SoftwareRenderer::WriteSampleColors(int pixelIndex, int sampleMask, const ColorRGB& color)
+{
+	const int sampleCount{ m_Width * m_Height * m_SampleCount };
+	for (int maskLeft{ sampleMask }; maskLeft != 0; maskLeft &= maskLeft - 1)
+	{
+		const int sampleIndex{ pixelIndex * m_SampleCount + std::countr_zero(static_cast<uint32_t>(maskLeft)) };
+		m_pSampleColorPixels[sampleIndex] = color.r;
+		m_pSampleColorPixels[sampleCount + sampleIndex] = color.g;
+		m_pSampleColorPixels[sampleCount * 2 + sampleIndex] = color.b;
+	}
+}
+
+void SoftwareRenderer::ResolveSamples(int minX, int minY, int maxX, int maxY)
+{
+	// Box filter, every sample gets brought into range first so bright edges still blend smoothly
+	const int pixelCount{ m_Width * m_Height };
+	const int sampleCount{ pixelCount * m_SampleCount };
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		int px{ minX };
+#if defined(__AVX2__)
+		if (m_UseSimd)
+		{
+			px = ResolveSamplesRowSimd(py * m_Width, minX, maxX);
+		}
+#endif
+
+		for (; px < maxX; ++px)
+		{
+			const int pixelIndex{ py * m_Width + px };
+
+			ColorRGB resolvedColor{};
+			for (int sampleIndex{ pixelIndex * m_SampleCount }; sampleIndex < (pixelIndex + 1) * m_SampleCount; ++sampleIndex)
+			{
+				ColorRGB sampleColor{ m_pSampleColorPixels[sampleIndex], m_pSampleColorPixels[sampleCount + sampleIndex], m_pSampleColorPixels[sampleCount * 2 + sampleIndex] };
+				sampleColor.MaxToOne();
+				resolvedColor += sampleColor;
+			}
+
+			WriteColor(pixelIndex, resolvedColor * (1.f / m_SampleCount));
+		}
+	}
+}
+
+#if defined(__AVX2__)
+int SoftwareRenderer::ResolveSamplesRowSimd(int rowIndex, int minX, int maxX)
+{
+	// Same steps as the scalar loop, 8 pixels at a time
+	// Their 32 samples get transposed so every register holds the same sample of 8 pixels, keeping the scalar sum order
+	const int pixelCount{ m_Width * m_Height };
+	const int sampleCount{ pixelCount * m_SampleCount };
+
+	const __m256 one{ _mm256_set1_ps(1.f) };
+	const __m256 sampleWeight{ _mm256_set1_ps(1.f / m_SampleCount) };
+
+	// Transposing within 128-bit lanes leaves the pixels in 0, 2, 4, 6, 1, 3, 5, 7 order
+	const __m256i pixelOrder{ _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7) };
+
+	int px{ minX };
+	for (; px + 8 <= maxX; px += 8)
+	{
+		const int firstSampleIndex{ (rowIndex + px) * m_SampleCount };
+
+		__m256 red[m_SampleCount]{};
+		__m256 green[m_SampleCount]{};
+		__m256 blue[m_SampleCount]{};
+		for (int groupIdx{}; groupIdx < m_SampleCount; ++groupIdx)
+		{
+			red[groupIdx] = _mm256_loadu_ps(m_pSampleColorPixels + firstSampleIndex + groupIdx * 8);
+			green[groupIdx] = _mm256_loadu_ps(m_pSampleColorPixels + sampleCount + firstSampleIndex + groupIdx * 8);
+			blue[groupIdx] = _mm256_loadu_ps(m_pSampleColorPixels + sampleCount * 2 + firstSampleIndex + groupIdx * 8);
+
+			// MaxToOne per sample
+			const __m256 maxValue{ _mm256_max_ps(red[groupIdx], _mm256_max_ps(green[groupIdx], blue[groupIdx])) };
+			const __m256 isOverOne{ _mm256_cmp_ps(maxValue, one, _CMP_GT_OQ) };
+			red[groupIdx] = _mm256_blendv_ps(red[groupIdx], _mm256_div_ps(red[groupIdx], maxValue), isOverOne);
+			green[groupIdx] = _mm256_blendv_ps(green[groupIdx], _mm256_div_ps(green[groupIdx], maxValue), isOverOne);
+			blue[groupIdx] = _mm256_blendv_ps(blue[groupIdx], _mm256_div_ps(blue[groupIdx], maxValue), isOverOne);
+		}
+
+		const auto resolve = [&](const __m256* pChannel, float* pDestination)
+			{
+				const __m256 low01{ _mm256_unpacklo_ps(pChannel[0], pChannel[1]) };
+				const __m256 high01{ _mm256_unpackhi_ps(pChannel[0], pChannel[1]) };
+				const __m256 low23{ _mm256_unpacklo_ps(pChannel[2], pChannel[3]) };
+				const __m256 high23{ _mm256_unpackhi_ps(pChannel[2], pChannel[3]) };
+
+				__m256 sum{ _mm256_add_ps(_mm256_setzero_ps(), _mm256_shuffle_ps(low01, low23, 0x44)) };
+				sum = _mm256_add_ps(sum, _mm256_shuffle_ps(low01, low23, 0xEE));
+				sum = _mm256_add_ps(sum, _mm256_shuffle_ps(high01, high23, 0x44));
+				sum = _mm256_add_ps(sum, _mm256_shuffle_ps(high01, high23, 0xEE));
+				_mm256_storeu_ps(pDestination, _mm256_permutevar8x32_ps(_mm256_mul_ps(sum, sampleWeight), pixelOrder));
+			};
+
+		resolve(red, m_pColorBufferPixels + rowIndex + px);
+		resolve(green, m_pColorBufferPixels + pixelCount + rowIndex + px);
+		resolve(blue, m_pColorBufferPixels + pixelCount * 2 + rowIndex + px);
+	}
+
+	return px;
+}
+#endif
+
+void SoftwareRenderer::ResolveColorTile(uint32_t tileIdx)
+{
+	DAE_PROFILE_SCOPE("SoftwareRenderer::ResolveColorTile");
+
+	// Tile pixel bounds
+	int tileMinX{}, tileMinY{}, tileMaxX{}, tileMaxY{};
+	GetTileBounds(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+
+	const SDL_PixelFormat* pFormat{ m_pRenderTarget->format };
+	const int pixelCount{ m_Width * m_Height };
+
+	// Every 32-bit format with 8-bit channels packs with plain shifts
+	const bool canPack{ pFormat->BytesPerPixel == 4 && pFormat->Rloss == 0 && pFormat->Gloss == 0 && pFormat->Bloss == 0 };
+
+	// Nothing drew here, its color planes still hold last frame, write the clear color straight away
+	if (!m_TileCleared[tileIdx])
+	{
+		for (int py{ tileMinY }; py < tileMaxY; ++py)
+		{
+			uint8_t* pRow{ static_cast<uint8_t*>(m_pRenderTarget->pixels) + py * m_pRenderTarget->pitch };
+			for (int px{ tileMinX }; px < tileMaxX; ++px)
+			{
+				std::memcpy(pRow + px * pFormat->BytesPerPixel, &m_ClearPixel, pFormat->BytesPerPixel);
+			}
+		}
+
+		if (m_ShadingRateMode == ShadingRateMode::Adaptive) UpdateShadingRates(tileIdx);
+		return;
+	}
+
+	// Samples to pixels first, the packing below stays the same
+	if (m_UseMsaa)
+	{
+		ResolveSamples(tileMinX, tileMinY, tileMaxX, tileMaxY);
+	}
+
+	// This frame's colors pick next frame's rates
+	if (m_ShadingRateMode == ShadingRateMode::Adaptive) UpdateShadingRates(tileIdx);
+
+	for (int py{ tileMinY }; py < tileMaxY; ++py)
+	{
+		const int rowIndex{ py * m_Width };
+		uint8_t* pRow{ static_cast<uint8_t*>(m_pRenderTarget->pixels) + py * m_pRenderTarget->pitch };
+
+		int px{ tileMinX };
+#if defined(__AVX2__)
+		if (m_UseSimd && canPack)
+		{
+			px = ResolveRowSimd(rowIndex, reinterpret_cast<uint32_t*>(pRow), tileMinX, tileMaxX);
+		}
+#endif
+
+		for (; px < tileMaxX; ++px)
+		{
+			const int pixelIndex{ rowIndex + px };
+			const uint32_t pixel{ PackColor(ColorRGB{ m_pColorBufferPixels[pixelIndex], m_pColorBufferPixels[pixelCount + pixelIndex], m_pColorBufferPixels[pixelCount * 2 + pixelIndex] }) };
+			std::memcpy(pRow + px * pFormat->BytesPerPixel, &pixel, pFormat->BytesPerPixel);
+		}
+	}
+
+#if defined(__AVX2__)
+	// Streaming stores aren't ordered with normal ones, finish them before presenting
+	_mm_sfence();
+#endif
+}
+
+uint32_t SoftwareRenderer::PackColor(ColorRGB color) const
+{
+	const SDL_PixelFormat* pFormat{ m_pBackBuffer->format };
+
+	color.MaxToOne();
+
+	const uint8_t red{ EncodeChannel(color.r) };
+	const uint8_t green{ EncodeChannel(color.g) };
+	const uint8_t blue{ EncodeChannel(color.b) };
+
+	// Anything odd goes through SDL
+	if (pFormat->BytesPerPixel == 4 && pFormat->Rloss == 0 && pFormat->Gloss == 0 && pFormat->Bloss == 0)
+	{
+		return (static_cast<uint32_t>(red) << pFormat->Rshift) | (static_cast<uint32_t>(green) << pFormat->Gshift)
+			| (static_cast<uint32_t>(blue) << pFormat->Bshift) | pFormat->Amask;
+	}
+
+	return SDL_MapRGB(pFormat, red, green, blue);
+}
+
+uint8_t SoftwareRenderer::EncodeChannel(float value) const
+{
+	// Clamp, then either sRGB encode or store linear
+	value = std::min(std::max(value, 0.f), 1.f);
+
+	if (m_UseSrgbOutput)
+	{
+		return static_cast<uint8_t>(m_SrgbLut[static_cast<int>(value * (m_SrgbLutSize - 1) + 0.5f)]);
+	}
+
+	return static_cast<uint8_t>(value * 255);
+}
+
+void SoftwareRenderer::CountFragment(int pixelIndex, bool passedDepthTest)
+{
+	// Pixels belong to a single tile, so no other thread touches the count
+	if (passedDepthTest != (m_HeatmapMode == HeatmapMode::Overdraw)) return;
+
+	uint16_t& count{ m_HeatmapCounts[pixelIndex] };
+	if (count < UINT16_MAX) ++count;
+}
+
+void SoftwareRenderer::WriteHeatmapTile(uint32_t tileIdx, uint64_t maxTileCost)
+{
+	DAE_PROFILE_SCOPE("SoftwareRenderer::WriteHeatmapTile");
+
+	// Tile pixel bounds
+	int tileMinX{}, tileMinY{}, tileMaxX{}, tileMaxY{};
+	GetTileBounds(tileIdx, tileMinX, tileMinY, tileMaxX, tileMaxY);
+
+	// Heat colors are display values, they skip the sRGB encode
+	const SDL_PixelFormat* pFormat{ m_pRenderTarget->format };
+	const auto mapHeat = [pFormat](float heat)
+		{
+			const ColorRGB color{ GetHeatmapColor(heat) };
+			return SDL_MapRGB(pFormat, static_cast<uint8_t>(color.r * 255.f + 0.5f), static_cast<uint8_t>(color.g * 255.f + 0.5f), static_cast<uint8_t>(color.b * 255.f + 0.5f));
+		};
+
+	// One pixel per count, anything past the max count is as hot as it gets
+	uint32_t heatPixels[m_HeatmapMaxCount + 1]{};
+	if (m_HeatmapMode == HeatmapMode::TileCost)
+	{
+		const float heat{ maxTileCost > 0 ? static_cast<float>(m_TileCostNanoseconds[tileIdx]) / maxTileCost : 0.f };
+		std::fill(std::begin(heatPixels), std::end(heatPixels), mapHeat(heat));
+	}
+	else
+	{
+		for (int count{}; count <= m_HeatmapMaxCount; ++count)
+		{
+			heatPixels[count] = mapHeat(static_cast<float>(count) / m_HeatmapMaxCount);
+		}
+	}
+
+	for (int py{ tileMinY }; py < tileMaxY; ++py)
+	{
+		uint8_t* pRow{ static_cast<uint8_t*>(m_pRenderTarget->pixels) + py * m_pRenderTarget->pitch };
+		for (int px{ tileMinX }; px < tileMaxX; ++px)
+		{
+			const int count{ m_HeatmapMode == HeatmapMode::TileCost ? 0 : std::min(static_cast<int>(m_HeatmapCounts[py * m_Width + px]), m_HeatmapMaxCount) };
+			std::memcpy(pRow + px * pFormat->BytesPerPixel, &heatPixels[count], pFormat->BytesPerPixel);
+		}
+	}
+}
+
+ColorRGB SoftwareRenderer::GetHeatmapColor(float heat)
+{
+	// Evenly spaced stops, linear in between
+	const ColorRGB stops[]{ ColorRGB{ 0.f, 0.f, 0.f }, ColorRGB{ 0.f, 0.f, 1.f }, ColorRGB{ 0.f, 1.f, 0.f }, ColorRGB{ 1.f, 1.f, 0.f }, ColorRGB{ 1.f, 0.f, 0.f } };
+	constexpr int lastStop{ static_cast<int>(std::size(stops)) - 1 };
+
+	const float position{ std::clamp(heat, 0.f, 1.f) * lastStop };
+	const int stopIdx{ std::min(static_cast<int>(position), lastStop - 1) };
+	const float weight{ position - static_cast<float>(stopIdx) };
+
+	return stops[stopIdx] * (1.f - weight) + stops[stopIdx + 1] * weight;
+}
+
+const char* SoftwareRenderer::GetHeatmapName() const
+{
+	switch (m_HeatmapMode)
+	{
+	case HeatmapMode::Overdraw:
+		return "Overdraw";
+	case HeatmapMode::DepthFailures:
+		return "DepthFailures";
+	case HeatmapMode::TileCost:
+		return "TileCost";
+	default:
+		return "Frame";
+	}
+}
+
+#if defined(__AVX2__)
+int SoftwareRenderer::ResolveRowSimd(int rowIndex, uint32_t* pRow, int minX, int maxX) const
+{
+	// Same steps as the scalar loop, 8 pixels at a time
+	const SDL_PixelFormat* pFormat{ m_pBackBuffer->format };
+	const int pixelCount{ m_Width * m_Height };
+
+	const float* pRed{ m_pColorBufferPixels + rowIndex };
+	const float* pGreen{ m_pColorBufferPixels + pixelCount + rowIndex };
+	const float* pBlue{ m_pColorBufferPixels + pixelCount * 2 + rowIndex };
+
+	const __m256 zero{ _mm256_setzero_ps() };
+	const __m256 one{ _mm256_set1_ps(1.f) };
+	const __m256 channelScale{ _mm256_set1_ps(255.f) };
+	const __m256 lutScale{ _mm256_set1_ps(static_cast<float>(m_SrgbLutSize - 1)) };
+	const __m256 half{ _mm256_set1_ps(0.5f) };
+
+	const __m128i redShift{ _mm_cvtsi32_si128(pFormat->Rshift) };
+	const __m128i greenShift{ _mm_cvtsi32_si128(pFormat->Gshift) };
+	const __m128i blueShift{ _mm_cvtsi32_si128(pFormat->Bshift) };
+	const __m256i alphaMask{ _mm256_set1_epi32(static_cast<int>(pFormat->Amask)) };
+
+	const auto encode = [&](__m256 value)
+		{
+			value = _mm256_min_ps(_mm256_max_ps(value, zero), one);
+
+			if (m_UseSrgbOutput)
+			{
+				const __m256i lutIndices{ _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, lutScale), half)) };
+				return _mm256_i32gather_epi32(reinterpret_cast<const int*>(m_SrgbLut.data()), lutIndices, sizeof(uint32_t));
+			}
+
+			return _mm256_cvttps_epi32(_mm256_mul_ps(value, channelScale));
+		};
+
+	int px{ minX };
+	for (; px + 8 <= maxX; px += 8)
+	{
+		__m256 red{ _mm256_loadu_ps(pRed + px) };
+		__m256 green{ _mm256_loadu_ps(pGreen + px) };
+		__m256 blue{ _mm256_loadu_ps(pBlue + px) };
+
+		// MaxToOne
+		const __m256 maxValue{ _mm256_max_ps(red, _mm256_max_ps(green, blue)) };
+		const __m256 isOverOne{ _mm256_cmp_ps(maxValue, one, _CMP_GT_OQ) };
+		red = _mm256_blendv_ps(red, _mm256_div_ps(red, maxValue), isOverOne);
+		green = _mm256_blendv_ps(green, _mm256_div_ps(green, maxValue), isOverOne);
+		blue = _mm256_blendv_ps(blue, _mm256_div_ps(blue, maxValue), isOverOne);
+
+		// Pack to the native format
+		const __m256i pixels{ _mm256_or_si256(_mm256_or_si256(_mm256_sll_epi32(encode(red), redShift), _mm256_sll_epi32(encode(green), greenShift)),
+			_mm256_or_si256(_mm256_sll_epi32(encode(blue), blueShift), alphaMask)) };
+
+		// The backBuffer is only written, keep it out of the cache when possible
+		__m256i* pDestination{ reinterpret_cast<__m256i*>(pRow + px) };
+		if ((reinterpret_cast<uintptr_t>(pDestination) & 31) == 0)
+		{
+			_mm256_stream_si256(pDestination, pixels);
+		}
+		else
+		{
+			_mm256_storeu_si256(pDestination, pixels);
+		}
+	}
+
+	return px;
+}
+#endif
+
+void SoftwareRenderer::UpscaleRows(int firstRow, int lastRow) const
+{
+	DAE_PROFILE_SCOPE("SoftwareRenderer::UpscaleRows");
+
+	const uint8_t* pSource{ static_cast<const uint8_t*>(m_pScaledBuffer->pixels) };
+	uint8_t* pDestination{ static_cast<uint8_t*>(m_pBackBuffer->pixels) };
+
+	// 8-bit weights, every channel gets filtered the same way so the pixel format doesn't matter
+	const auto lerp = [](uint32_t from, uint32_t to, uint32_t weight)
+		{
+			return (from * (256 - weight) + to * weight + 128) >> 8;
+		};
+
+	for (int py{ firstRow }; py < lastRow; ++py)
+	{
+		int firstSourceRow{};
+		int secondSourceRow{};
+		uint16_t weightY{};
+		GetUpscaleSourceRow(py, firstSourceRow, secondSourceRow, weightY);
+
+		const uint32_t* pFirstSourceRow{ reinterpret_cast<const uint32_t*>(pSource + firstSourceRow * m_pScaledBuffer->pitch) };
+		const uint32_t* pSecondSourceRow{ reinterpret_cast<const uint32_t*>(pSource + secondSourceRow * m_pScaledBuffer->pitch) };
+		uint32_t* pRow{ reinterpret_cast<uint32_t*>(pDestination + py * m_pBackBuffer->pitch) };
+
+		int px{};
+#if defined(__AVX2__)
+		if (m_UseSimd)
+		{
+			px = UpscaleRowSimd(pFirstSourceRow, pSecondSourceRow, pRow, weightY);
+		}
+#endif
+
+		for (; px < m_WindowWidth; ++px)
+		{
+			const uint32_t topLeft{ pFirstSourceRow[m_UpscaleSourceX0[px]] };
+			const uint32_t topRight{ pFirstSourceRow[m_UpscaleSourceX1[px]] };
+			const uint32_t bottomLeft{ pSecondSourceRow[m_UpscaleSourceX0[px]] };
+			const uint32_t bottomRight{ pSecondSourceRow[m_UpscaleSourceX1[px]] };
+			const uint32_t weightX{ m_UpscaleWeightsX[px * 4] };
+
+			uint32_t pixel{};
+			for (int shift{}; shift < 32; shift += 8)
+			{
+				const uint32_t top{ lerp((topLeft >> shift) & 0xFF, (topRight >> shift) & 0xFF, weightX) };
+				const uint32_t bottom{ lerp((bottomLeft >> shift) & 0xFF, (bottomRight >> shift) & 0xFF, weightX) };
+				pixel |= lerp(top, bottom, weightY) << shift;
+			}
+			pRow[px] = pixel;
+		}
+	}
+}
+
+void SoftwareRenderer::GetUpscaleSourceRow(int row, int& firstSourceRow, int& secondSourceRow, uint16_t& weight) const
+{
+	// Same mapping as the columns, see SetRenderSize
+	const float sourceY{ std::max((row + 0.5f) * m_Height / m_WindowHeight - 0.5f, 0.f) };
+	firstSourceRow = std::min(static_cast<int>(sourceY), m_Height - 1);
+	secondSourceRow = std::min(firstSourceRow + 1, m_Height - 1);
+	weight = std::min(static_cast<uint16_t>((sourceY - static_cast<float>(firstSourceRow)) * 256.f), uint16_t{ 255 });
+}
+
+#if defined(__AVX2__)
+int SoftwareRenderer::UpscaleRowSimd(const uint32_t* pFirstSourceRow, const uint32_t* pSecondSourceRow, uint32_t* pRow, uint16_t weightY) const
+{
+	// Same integer math as the scalar loop, 8 pixels at a time with every channel widened to 16 bits
+	// The products stay below 2^16, so the 16-bit multiplies are exact
+	const __m256i rounding{ _mm256_set1_epi16(128) };
+	const __m256i fullWeight{ _mm256_set1_epi16(256) };
+	const __m256i secondWeightY{ _mm256_set1_epi16(static_cast<short>(weightY)) };
+	const __m256i firstWeightY{ _mm256_sub_epi16(fullWeight, secondWeightY) };
+
+	const auto lerp = [&](__m256i from, __m256i to, __m256i fromWeight, __m256i toWeight)
+		{
+			return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(from, fromWeight), _mm256_mullo_epi16(to, toWeight)), rounding), 8);
+		};
+
+	// 4 pixels of 4 channels each
+	const auto filterHalf = [&](__m128i topLeft, __m128i topRight, __m128i bottomLeft, __m128i bottomRight, __m256i secondWeightX)
+		{
+			const __m256i firstWeightX{ _mm256_sub_epi16(fullWeight, secondWeightX) };
+			const __m256i top{ lerp(_mm256_cvtepu8_epi16(topLeft), _mm256_cvtepu8_epi16(topRight), firstWeightX, secondWeightX) };
+			const __m256i bottom{ lerp(_mm256_cvtepu8_epi16(bottomLeft), _mm256_cvtepu8_epi16(bottomRight), firstWeightX, secondWeightX) };
+			return lerp(top, bottom, firstWeightY, secondWeightY);
+		};
+
+	int px{};
+	for (; px + 8 <= m_WindowWidth; px += 8)
+	{
+		const __m256i firstColumns{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_UpscaleSourceX0.data() + px)) };
+		const __m256i secondColumns{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_UpscaleSourceX1.data() + px)) };
+		const __m256i topLeft{ _mm256_i32gather_epi32(reinterpret_cast<const int*>(pFirstSourceRow), firstColumns, sizeof(uint32_t)) };
+		const __m256i topRight{ _mm256_i32gather_epi32(reinterpret_cast<const int*>(pFirstSourceRow), secondColumns, sizeof(uint32_t)) };
+		const __m256i bottomLeft{ _mm256_i32gather_epi32(reinterpret_cast<const int*>(pSecondSourceRow), firstColumns, sizeof(uint32_t)) };
+		const __m256i bottomRight{ _mm256_i32gather_epi32(reinterpret_cast<const int*>(pSecondSourceRow), secondColumns, sizeof(uint32_t)) };
+
+		const __m256i lowPixels{ filterHalf(_mm256_castsi256_si128(topLeft), _mm256_castsi256_si128(topRight),
+			_mm256_castsi256_si128(bottomLeft), _mm256_castsi256_si128(bottomRight),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_UpscaleWeightsX.data() + px * 4))) };
+		const __m256i highPixels{ filterHalf(_mm256_extracti128_si256(topLeft, 1), _mm256_extracti128_si256(topRight, 1),
+			_mm256_extracti128_si256(bottomLeft, 1), _mm256_extracti128_si256(bottomRight, 1),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_UpscaleWeightsX.data() + px * 4 + 16))) };
+
+		// Packing works per 128-bit lane, which swaps the middle pairs of pixels
+		const __m256i pixels{ _mm256_permute4x64_epi64(_mm256_packus_epi16(lowPixels, highPixels), 0xD8) };
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(pRow + px), pixels);
+	}
+
+	return px;
+}
+#endif
+
+void SoftwareRenderer::VertexTransformationFunction(const std::vector<VS_INPUT>& vertices_in, VertexStreams& vertices_out, const Matrix& worldMatrix) const
+{
+	DAE_PROFILE_SCOPE("SoftwareRenderer::VertexTransformationFunction");
+
+	vertices_out.Resize(vertices_in.size());
+
+	const Matrix cameraInvViewMatrix{ m_pCamera->GetInvViewMatrix() };
+	const Matrix cameraProjectionMatrix{ m_pCamera->GetProjectionMatrix() };
+
+	const Matrix viewMatrix{ cameraInvViewMatrix };
+	const Matrix projectionMatrix{ cameraProjectionMatrix };
+	const Matrix worldViewProjectionMatrix{ worldMatrix * viewMatrix * projectionMatrix };
+
+	// Every vertex is independent, so batches can go to the workers
+	const uint32_t batchCount{ static_cast<uint32_t>((vertices_in.size() + m_VertexBatchSize - 1) / m_VertexBatchSize) };
+	m_pThreadPool->ParallelFor(batchCount, [&](uint32_t batchIdx, uint32_t)
+		{
+			const size_t firstIdx{ static_cast<size_t>(batchIdx) * m_VertexBatchSize };
+			const size_t lastIdx{ std::min(firstIdx + m_VertexBatchSize, vertices_in.size()) };
+
+			TransformVertices(vertices_in, vertices_out, worldViewProjectionMatrix, worldMatrix, firstIdx, lastIdx);
+		});
+}
+
+void SoftwareRenderer::TransformVertices(const std::vector<VS_INPUT>& vertices_in, VertexStreams& vertices_out, const Matrix& worldViewProjectionMatrix, const Matrix& worldMatrix, size_t firstIdx, size_t lastIdx) const
+{
+	// 8 vertices at a time, the scalar loop picks up what is left
+#if defined(__AVX2__)
+	if (m_UseSimd)
+	{
+		firstIdx = TransformVerticesSimd(vertices_in, vertices_out, worldViewProjectionMatrix, worldMatrix, firstIdx, lastIdx);
+	}
+#endif
+
+	for (size_t idx{ firstIdx }; idx < lastIdx; ++idx)
+	{
+		// Only referenced by culled triangles
+		if (!m_pVertexUsed[idx]) continue;
+
+		const VS_INPUT& currentVertex{ vertices_in[idx] };
+
+		// Clip space, clipping happens in triangle setup
+		const Vector4 transformedPosition{ worldViewProjectionMatrix.TransformPoint(Vector4{ currentVertex.Position, 0 }) };
+
+		const Vector3 normal{ worldMatrix.TransformVector(currentVertex.normal) };
+		const Vector3 tangent{ worldMatrix.TransformVector(currentVertex.tangent) };
+
+		// Put in vertexOut
+		vertices_out.positionX[idx] = transformedPosition.x;
+		vertices_out.positionY[idx] = transformedPosition.y;
+		vertices_out.positionZ[idx] = transformedPosition.z;
+		vertices_out.positionW[idx] = transformedPosition.w;
+		vertices_out.u[idx] = currentVertex.UV.x;
+		vertices_out.v[idx] = currentVertex.UV.y;
+		vertices_out.normalX[idx] = normal.x;
+		vertices_out.normalY[idx] = normal.y;
+		vertices_out.normalZ[idx] = normal.z;
+		vertices_out.tangentX[idx] = tangent.x;
+		vertices_out.tangentY[idx] = tangent.y;
+		vertices_out.tangentZ[idx] = tangent.z;
+
+		ProjectVertex(vertices_out, idx);
+	}
+}
+
+#if defined(__AVX2__)
+size_t SoftwareRenderer::TransformVerticesSimd(const std::vector<VS_INPUT>& vertices_in, VertexStreams& vertices_out, const Matrix& worldViewProjectionMatrix, const Matrix& worldMatrix, size_t firstIdx, size_t lastIdx) const
+{
+	// Same math and order as Matrix::TransformPoint/TransformVector and ProjectVertex, so both paths match bit for bit
+	__m256 worldViewProjection[4][4]{};
+	__m256 world[3][3]{};
+	for (int row{}; row < 4; ++row)
+	{
+		for (int column{}; column < 4; ++column)
+		{
+			worldViewProjection[row][column] = _mm256_set1_ps(worldViewProjectionMatrix[row][column]);
+			if (row < 3 && column < 3) world[row][column] = _mm256_set1_ps(worldMatrix[row][column]);
+		}
+	}
+
+	const auto transformPoint = [&](int column, const __m256& x, const __m256& y, const __m256& z)
+		{
+			return _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(worldViewProjection[0][column], x),
+				_mm256_mul_ps(worldViewProjection[1][column], y)), _mm256_mul_ps(worldViewProjection[2][column], z)), worldViewProjection[3][column]);
+		};
+	const auto transformVector = [&](int column, const __m256& x, const __m256& y, const __m256& z)
+		{
+			return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(world[0][column], x), _mm256_mul_ps(world[1][column], y)), _mm256_mul_ps(world[2][column], z));
+		};
+
+	// Input is an array of structures, gather one component of 8 vertices at a time
+	constexpr int vertexStride{ sizeof(VS_INPUT) / sizeof(float) };
+	const __m256i gatherIndices{ _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(vertexStride)) };
+
+	constexpr int positionOffset{ offsetof(VS_INPUT, Position) / sizeof(float) };
+	constexpr int uvOffset{ offsetof(VS_INPUT, UV) / sizeof(float) };
+	constexpr int normalOffset{ offsetof(VS_INPUT, normal) / sizeof(float) };
+	constexpr int tangentOffset{ offsetof(VS_INPUT, tangent) / sizeof(float) };
+
+	const __m256 one{ _mm256_set1_ps(1.f) };
+	const __m256 two{ _mm256_set1_ps(2.f) };
+	const __m256 width{ _mm256_set1_ps(static_cast<float>(m_Width)) };
+	const __m256 height{ _mm256_set1_ps(static_cast<float>(m_Height)) };
+
+	size_t idx{ firstIdx };
+	for (; idx + 8 <= lastIdx; idx += 8)
+	{
+		// Skip groups that only belong to culled triangles
+		uint64_t usedFlags{};
+		std::memcpy(&usedFlags, m_pVertexUsed + idx, sizeof(usedFlags));
+		if (usedFlags == 0) continue;
+
+		const float* pVertex{ reinterpret_cast<const float*>(vertices_in.data() + idx) };
+		const auto gather = [&](int offset) { return _mm256_i32gather_ps(pVertex + offset, gatherIndices, sizeof(float)); };
+
+		// Position
+		const __m256 positionX{ gather(positionOffset) };
+		const __m256 positionY{ gather(positionOffset + 1) };
+		const __m256 positionZ{ gather(positionOffset + 2) };
+
+		const __m256 clipX{ transformPoint(0, positionX, positionY, positionZ) };
+		const __m256 clipY{ transformPoint(1, positionX, positionY, positionZ) };
+		const __m256 clipZ{ transformPoint(2, positionX, positionY, positionZ) };
+		const __m256 clipW{ transformPoint(3, positionX, positionY, positionZ) };
+
+		_mm256_storeu_ps(vertices_out.positionX.data() + idx, clipX);
+		_mm256_storeu_ps(vertices_out.positionY.data() + idx, clipY);
+		_mm256_storeu_ps(vertices_out.positionZ.data() + idx, clipZ);
+		_mm256_storeu_ps(vertices_out.positionW.data() + idx, clipW);
+
+		// Perspective Divide
+		const __m256 ndcX{ _mm256_div_ps(clipX, clipW) };
+		const __m256 ndcY{ _mm256_div_ps(clipY, clipW) };
+
+		_mm256_storeu_ps(vertices_out.rasterX.data() + idx, _mm256_mul_ps(_mm256_div_ps(_mm256_add_ps(ndcX, one), two), width));
+		_mm256_storeu_ps(vertices_out.rasterY.data() + idx, _mm256_mul_ps(_mm256_div_ps(_mm256_sub_ps(one, ndcY), two), height));
+		_mm256_storeu_ps(vertices_out.rasterZ.data() + idx, _mm256_div_ps(clipZ, clipW));
+		_mm256_storeu_ps(vertices_out.inverseW.data() + idx, _mm256_div_ps(one, clipW));
+
+		// UV
+		_mm256_storeu_ps(vertices_out.u.data() + idx, gather(uvOffset));
+		_mm256_storeu_ps(vertices_out.v.data() + idx, gather(uvOffset + 1));
+
+		// Normal and tangent
+		const __m256 normalX{ gather(normalOffset) };
+		const __m256 normalY{ gather(normalOffset + 1) };
+		const __m256 normalZ{ gather(normalOffset + 2) };
+
+		_mm256_storeu_ps(vertices_out.normalX.data() + idx, transformVector(0, normalX, normalY, normalZ));
+		_mm256_storeu_ps(vertices_out.normalY.data() + idx, transformVector(1, normalX, normalY, normalZ));
+		_mm256_storeu_ps(vertices_out.normalZ.data() + idx, transformVector(2, normalX, normalY, normalZ));
+
+		const __m256 tangentX{ gather(tangentOffset) };
+		const __m256 tangentY{ gather(tangentOffset + 1) };
+		const __m256 tangentZ{ gather(tangentOffset + 2) };
+
+		_mm256_storeu_ps(vertices_out.tangentX.data() + idx, transformVector(0, tangentX, tangentY, tangentZ));
+		_mm256_storeu_ps(vertices_out.tangentY.data() + idx, transformVector(1, tangentX, tangentY, tangentZ));
+		_mm256_storeu_ps(vertices_out.tangentZ.data() + idx, transformVector(2, tangentX, tangentY, tangentZ));
+	}
+
+	return idx;
+}
+#endif
+
+void SoftwareRenderer::ProjectVertex(VertexStreams& vertices, size_t idx) const
+{
+	// Perspective Divide
+	const float ndcX{ vertices.positionX[idx] / vertices.positionW[idx] };
+	const float ndcY{ vertices.positionY[idx] / vertices.positionW[idx] };
+
+	vertices.rasterX[idx] = ((ndcX + 1) / 2) * m_Width;
+	vertices.rasterY[idx] = ((1 - ndcY) / 2) * m_Height;
+	vertices.rasterZ[idx] = vertices.positionZ[idx] / vertices.positionW[idx];
+	vertices.inverseW[idx] = 1 / vertices.positionW[idx];
+}
+
+uint32_t SoftwareRenderer::PushClippedVertex(const VS_OUPUT& vertex)
+{
+	const uint32_t idx{ m_VerticesOut.PushBack(vertex) };
+	ProjectVertex(m_VerticesOut, idx);
+
+	return idx;
+}
+
+void SoftwareRenderer::VertexStreams::Resize(size_t size)
+{
+	for (std::vector<float>* pStream : { &positionX, &positionY, &positionZ, &positionW, &u, &v,
+		&normalX, &normalY, &normalZ, &tangentX, &tangentY, &tangentZ, &rasterX, &rasterY, &rasterZ, &inverseW })
+	{
+		pStream->resize(size);
+	}
+}
+
+VS_OUPUT SoftwareRenderer::VertexStreams::Gather(uint32_t idx) const
+{
+	VS_OUPUT vertex{};
+	vertex.Position = GetPosition(idx);
+	vertex.UV = Vector2{ u[idx], v[idx] };
+	vertex.normal = Vector3{ normalX[idx], normalY[idx], normalZ[idx] };
+	vertex.tangent = Vector3{ tangentX[idx], tangentY[idx], tangentZ[idx] };
+
+	return vertex;
+}
+
+uint32_t SoftwareRenderer::VertexStreams::PushBack(const VS_OUPUT& vertex)
+{
+	const uint32_t idx{ static_cast<uint32_t>(GetSize()) };
+
+	positionX.push_back(vertex.Position.x);
+	positionY.push_back(vertex.Position.y);
+	positionZ.push_back(vertex.Position.z);
+	positionW.push_back(vertex.Position.w);
+	u.push_back(vertex.UV.x);
+	v.push_back(vertex.UV.y);
+	normalX.push_back(vertex.normal.x);
+	normalY.push_back(vertex.normal.y);
+	normalZ.push_back(vertex.normal.z);
+	tangentX.push_back(vertex.tangent.x);
+	tangentY.push_back(vertex.tangent.y);
+	tangentZ.push_back(vertex.tangent.z);
+
+	// Filled in by the perspective divide
+	rasterX.push_back(0.f);
+	rasterY.push_back(0.f);
+	rasterZ.push_back(0.f);
+	inverseW.push_back(0.f);
+
+	return idx;
+}
+
+bool SoftwareRenderer::SaveBufferToImage(const char* fileName) const
+{
+	// PNG through SDL_image, anything else is written as BMP
+	const size_t nameLength{ std::strlen(fileName) };
+	if (nameLength >= 4 && std::strcmp(fileName + nameLength - 4, ".png") == 0)
+	{
+		return IMG_SavePNG(m_pBackBuffer, fileName) == 0;
+	}
+
+	return SDL_SaveBMP(m_pBackBuffer, fileName) == 0;
+}
+
+bool SoftwareRenderer::ExportFrame() const
+{
+	const std::string fileName{ std::string{ "Rasterizer_" } + GetHeatmapName() + ".bmp" };
+	if (SaveBufferToImage(fileName.c_str()) == false)
+	{
+		std::cout << "Failed to write " << fileName << std::endl;
+		return false;
+	}
+
+	std::cout << "Frame written to " << fileName << std::endl;
+	return true;
+}
+
+const SoftwareRenderer::FrameTimings& SoftwareRenderer::GetFrameTimings() const
+{
+	return m_FrameTimings;
+}
+
+const SDL_Surface* SoftwareRenderer::GetBackBuffer() const
+{
+	return m_pBackBuffer;
+}
+
+void SoftwareRenderer::ToggleFilter()
+{
+	m_ShowDepthBuffer = !m_ShowDepthBuffer;
+
+	if (m_ShowDepthBuffer)
+	{
+		std::cout << "Enabled depth-buffer" << std::endl;
+	}
+	else
+	{
+		std::cout << "Disabled depth-buffer" << std::endl;
+	}
+}
+void SoftwareRenderer::ToggleShadingMode()
+{
+	switch (m_CurrentShadingMode)
+	{
+	case shadingModes::ObservedArea:
+		m_CurrentShadingMode = shadingModes::Diffuse;
+		std::cout << "Current shadingMode is diffuse" << std::endl;
+		break;
+
+	case shadingModes::Diffuse:
+		m_CurrentShadingMode = shadingModes::Specular;
+		std::cout << "Current shadingMode is specular" << std::endl;
+		break;
+
+	case shadingModes::Specular:
+		m_CurrentShadingMode = shadingModes::Combined;
+		std::cout << "Current shadingMode is combined" << std::endl;
+		break;
+
+	case shadingModes::Combined:
+		m_CurrentShadingMode = shadingModes::ObservedArea;
+		std::cout << "Current shadingMode is observedArea" << std::endl;
+		break;
+	}
+}
+void SoftwareRenderer::ToggleNormalMap()
+{
+	m_UseNormalMap = !m_UseNormalMap;
+
+	if (m_UseNormalMap)
+	{
+		std::cout << "normalMap on!" << '\n';
+	}
+	else
+	{
+		std::cout << "normalMap off!" << '\n';
+	}
+}
+void SoftwareRenderer::ToggleBoundingBox()
+{
+	m_ShowBoundingBoxes = !m_ShowBoundingBoxes;
+
+	if (m_ShowBoundingBoxes)
+	{
+		std::cout << "Enabled bounding-boxes visualization" << std::endl;
+	}
+	else
 	{
 		std::cout << "Disabled bounding-boxes visualization" << std::endl;
 	}
 }
 
+void SoftwareRenderer::ToggleVisibilityBuffer()
+{
+	m_UseVisibilityBuffer = !m_UseVisibilityBuffer;
+
+	if (m_UseVisibilityBuffer)
+	{
+		std::cout << "Enabled visibility-buffer shading" << std::endl;
+	}
+	else
+	{
+		std::cout << "Disabled visibility-buffer shading" << std::endl;
+	}
+}
+void SoftwareRenderer::ToggleDepthFormat()
+{
+	// Cycle through the formats
+	switch (m_DepthFormat)
+	{
+	case DepthFormat::Float32:
+		m_DepthFormat = DepthFormat::ReversedFloat32;
+		std::cout << "Depth format: 32-bit float, reversed" << std::endl;
+		break;
+	case DepthFormat::ReversedFloat32:
+		m_DepthFormat = DepthFormat::Unorm24;
+		std::cout << "Depth format: 24-bit unorm" << std::endl;
+		break;
+	case DepthFormat::Unorm24:
+		m_DepthFormat = DepthFormat::Unorm16;
+		std::cout << "Depth format: 16-bit unorm" << std::endl;
+		break;
+	case DepthFormat::Unorm16:
+		m_DepthFormat = DepthFormat::Float32;
+		std::cout << "Depth format: 32-bit float" << std::endl;
+		break;
+	}
+}
+
+void SoftwareRenderer::ToggleDepthCompression()
+{
+	m_UseDepthCompression = !m_UseDepthCompression;
+
+	if (m_UseDepthCompression)
+	{
+		std::cout << "Enabled per-tile depth compression" << std::endl;
+	}
+	else
+	{
+		std::cout << "Disabled per-tile depth compression" << std::endl;
+	}
+}
+
+void SoftwareRenderer::ToggleMsaa()
+{
+	m_UseMsaa = !m_UseMsaa;
+
+	// Sample buffers only exist once MSAA got used, tiles get cleared before their first use
+	if (m_UseMsaa && m_pSampleColorPixels == nullptr)
+	{
+		m_pSampleDepthPixels = new std::byte[m_WindowWidth * m_WindowHeight * m_SampleCount * sizeof(float)];
+		m_pSampleColorPixels = new float[m_WindowWidth * m_WindowHeight * m_SampleCount * 3];
+	}
+
+	if (m_UseMsaa)
+	{
+		std::cout << "Enabled 4x MSAA" << std::endl;
+	}
+	else
+	{
+		std::cout << "Disabled 4x MSAA" << std::endl;
+	}
+}
+
+void SoftwareRenderer::ToggleDynamicResolution()
+{
+	m_UseDynamicResolution = !m_UseDynamicResolution;
+
+	// Every run starts from a fresh estimate, turning it off goes back to the window size
+	m_FullResolutionFrameMs = 0.f;
+
+	if (m_UseDynamicResolution)
+	{
+		std::cout << "Enabled dynamic resolution, targeting " << m_TargetFrameMs << " ms" << std::endl;
+	}
+	else
+	{
+		m_ResolutionScale = 1.f;
+		std::cout << "Disabled dynamic resolution" << std::endl;
+	}
+}
+
+void SoftwareRenderer::SetResolutionScale(float scale)
+{
+	if (m_UseDynamicResolution) return;
+
+	m_ResolutionScale = std::clamp(scale, m_MinResolutionScale, 1.f);
+}
+float SoftwareRenderer::GetResolutionScale() const
+{
+	return m_ResolutionScale;
+}
+
+void SoftwareRenderer::SetTargetFrameTime(float milliseconds)
+{
+	m_TargetFrameMs = std::max(milliseconds, 0.1f);
+	m_FullResolutionFrameMs = 0.f;
+}
+
+void SoftwareRenderer::ToggleShadingRate()
+{
+	// Cycle through the modes, adaptive starts from full rate everywhere
+	switch (m_ShadingRateMode)
+	{
+	case ShadingRateMode::Full:
+		m_ShadingRateMode = ShadingRateMode::Adaptive;
+		std::fill(m_ShadingRates.begin(), m_ShadingRates.end(), uint8_t{});
+		std::cout << "Shading rate: adaptive, per 8x8 block from luminance" << std::endl;
+		break;
+	case ShadingRateMode::Adaptive:
+		m_ShadingRateMode = ShadingRateMode::Coarse;
+		std::cout << "Shading rate: 2x2" << std::endl;
+		break;
+	case ShadingRateMode::Coarse:
+		m_ShadingRateMode = ShadingRateMode::Full;
+		std::cout << "Shading rate: full" << std::endl;
+		break;
+	}
+}
+
+void SoftwareRenderer::TogglePresentBuffers()
+{
+	// Cycle through synchronous, double and triple buffering
+	SetPresentBufferCount(GetPresentBufferCount() % m_MaxPresentBufferCount + 1);
+
+	if (m_pPresentQueue != nullptr)
+	{
+		std::cout << "Presenting from a separate thread, " << GetPresentBufferCount() << " back buffers" << std::endl;
+	}
+	else
+	{
+		std::cout << "Presenting on the render thread" << std::endl;
+	}
+}
+
+void SoftwareRenderer::ToggleHeatmap()
+{
+	// Cycle through the views
+	switch (m_HeatmapMode)
+	{
+	case HeatmapMode::Off:
+		m_HeatmapMode = HeatmapMode::Overdraw;
+		std::cout << "Heatmap: overdraw, fragments passing the depth test per pixel (red at " << m_HeatmapMaxCount << ")" << std::endl;
+		break;
+	case HeatmapMode::Overdraw:
+		m_HeatmapMode = HeatmapMode::DepthFailures;
+		std::cout << "Heatmap: depth-test failures per pixel (red at " << m_HeatmapMaxCount << ")" << std::endl;
+		break;
+	case HeatmapMode::DepthFailures:
+		m_HeatmapMode = HeatmapMode::TileCost;
+		std::cout << "Heatmap: raster and shading time per tile, relative to the slowest tile" << std::endl;
+		break;
+	case HeatmapMode::TileCost:
+		m_HeatmapMode = HeatmapMode::Off;
+		std::cout << "Heatmap: off" << std::endl;
+		break;
+	}
+}
+
+void SoftwareRenderer::SetPresentBufferCount(uint32_t bufferCount)
+{
+	bufferCount = std::clamp(bufferCount, 1u, m_MaxPresentBufferCount);
+	if (bufferCount == GetPresentBufferCount()) return;
+
+	// Frames still in the old ring reach the screen first
+	delete m_pPresentQueue;
+	m_pPresentQueue = nullptr;
+	m_pBackBuffer = m_pSyncBackBuffer;
+	m_pBackBufferPixels = static_cast<uint32_t*>(m_pBackBuffer->pixels);
+
+	if (bufferCount > 1)
+	{
+		m_pPresentQueue = new PresentQueue{ m_pWindow, m_WindowWidth, m_WindowHeight, m_pSyncBackBuffer->format->format, bufferCount };
+	}
+}
+uint32_t SoftwareRenderer::GetPresentBufferCount() const
+{
+	return m_pPresentQueue != nullptr ? m_pPresentQueue->GetBufferCount() : 1;
+}
+
+void SoftwareRenderer::FlushPresent()
+{
+	if (m_pPresentQueue != nullptr) m_pPresentQueue->Flush();
+}
+
+double SoftwareRenderer::GetPresentLatencyMs() const
+{
+	return m_pPresentQueue != nullptr ? m_pPresentQueue->GetPresentLatencyMs() : m_FrameTimings.presentMs;
+}
+
+void SoftwareRenderer::ToggleSrgbOutput()
+{
+	m_UseSrgbOutput = !m_UseSrgbOutput;
+
+	if (m_UseSrgbOutput)
+	{
+		std::cout << "Enabled sRGB output encoding" << std::endl;
+	}
+	else
+	{
+		std::cout << "Disabled sRGB output encoding" << std::endl;
+	}
+}
+
+void SoftwareRenderer::ToggleSimd()
+{
+#if defined(__AVX2__)
+	m_UseSimd = !m_UseSimd;
+
+	if (m_UseSimd)
+	{
+		std::cout << "Enabled AVX2 vertex transform and rasterization" << std::endl;
+	}
+	else
+	{
+		std::cout << "Disabled AVX2 vertex transform and rasterization" << std::endl;
+	}
+#else
+	std::cout << "AVX2 vertex transform and rasterization are not available in this build" << std::endl;
+#endif
+}
+
+void SoftwareRenderer::SetThreadCount(uint32_t threadCount)
+{
+	// hardware_concurrency() is allowed to report 0
+	threadCount = std::max(threadCount, 1u);
+	if (m_pThreadPool && m_pThreadPool->GetThreadCount() == threadCount) return;
+
+	delete m_pThreadPool;
+	m_pThreadPool = new ThreadPool(threadCount);
+}
+uint32_t SoftwareRenderer::GetThreadCount() const
+{
+	return m_pThreadPool->GetThreadCount();
+}
+
+const SoftwareRenderer::ShadingStatistics& SoftwareRenderer::GetShadingStatistics() const
+{
+	return m_ShadingStatistics;
+}
+void SoftwareRenderer::PrintShadingStatistics() const
+{
+	const uint64_t depthPassedFragments{ m_ShadingStatistics.depthPassedFragments };
+	const uint64_t shadedPixels{ m_ShadingStatistics.shadedPixels };
+	const uint64_t savedShades{ depthPassedFragments > shadedPixels ? depthPassedFragments - shadedPixels : 0 };
+
+	std::cout << "Depth-passed fragments: " << depthPassedFragments
+		<< ", shaded pixels: " << shadedPixels
+		<< ", saved shades: " << savedShades << std::endl;
+
+	if (m_UseDynamicResolution || m_Width != m_WindowWidth || m_Height != m_WindowHeight)
+	{
+		std::cout << "Internal resolution: " << m_Width << "x" << m_Height << " (scale " << m_ResolutionScale << ")" << std::endl;
+	}
+
+	if (m_pPresentQueue != nullptr)
+	{
+		std::cout << "Present latency: " << m_pPresentQueue->GetPresentLatencyMs() << " ms over " << GetPresentBufferCount() << " back buffers" << std::endl;
+	}
+}
+
 bool SoftwareRenderer::IsValueBetweenBoundaries(float value, float minBound, float maxBound) const
 {
 	if (minBound <= value && value <= maxBound)
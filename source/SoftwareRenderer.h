@@ -1,7 +1,13 @@
 #pragma once
 
+#include <cfloat>
+#include <cstddef>
 #include <cstdint>
+#include <type_traits>
 #include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #include "Camera.h"
 #include "DataTypes.h"
@@ -16,10 +22,14 @@ namespace dae
 	struct Mesh;
 	class Timer;
 	class Scene;
+	class ThreadPool;
+	class FrameArena;
+	class PresentQueue;
 
 	class SoftwareRenderer final
 	{
 	public:
+		// pWindow can be nullptr, frames are then only rendered into the backBuffer
 		SoftwareRenderer(SDL_Window* pWindow, int windowWidth, int windowHeight,
 						const std::vector<VS_INPUT>& vertices, const std::vector<uint32_t>& indices,
 						Texture* pDiffuseTexture, Texture* pNormalTexture, Texture* pSpecularTexture, Texture* pGlossinessTexture,
@@ -35,12 +45,76 @@ namespace dae
 		void Update(const Timer* pTimer);
 		void Render();
 
-		bool SaveBufferToImage() const;
+		bool SaveBufferToImage(const char* fileName = "Rasterizer_ColorBuffer.bmp") const;
+
+		// Last rendered frame, 32-bit pixels in the surface's format
+		const SDL_Surface* GetBackBuffer() const;
 
 		void ToggleFilter();
 		void ToggleShadingMode();
 		void ToggleNormalMap();
 		void ToggleBoundingBox();
+		void ToggleSimd();
+		void ToggleVisibilityBuffer();
+		void ToggleSrgbOutput();
+		void ToggleDepthFormat();
+		void ToggleDepthCompression();
+		void ToggleMsaa();
+		void ToggleDynamicResolution();
+		void ToggleShadingRate();
+		void TogglePresentBuffers();
+
+		// Debug views replacing the final color, cycles off, overdraw, depth-test failures and tile cost
+		void ToggleHeatmap();
+
+		// Saves the last frame, named after the heatmap on screen
+		bool ExportFrame() const;
+
+		// 1 presents on the render thread, 2 or 3 hand frames to a present thread through a ring of back buffers
+		void SetPresentBufferCount(uint32_t bufferCount);
+		uint32_t GetPresentBufferCount() const;
+
+		// Blocks until every frame handed to the present thread is on screen, before anything else presents to the window
+		void FlushPresent();
+
+		// Submit to on screen of the last presented frame, or the present itself without a ring
+		double GetPresentLatencyMs() const;
+
+		// Internal resolution as a fraction of the window size, frames get upscaled to the window
+		// A fixed scale only applies while dynamic resolution is off
+		void SetResolutionScale(float scale);
+		float GetResolutionScale() const;
+
+		// Frame time dynamic resolution aims for, present excluded
+		void SetTargetFrameTime(float milliseconds);
+
+		void SetThreadCount(uint32_t threadCount);
+		uint32_t GetThreadCount() const;
+
+		// Work done by the last frame
+		struct ShadingStatistics
+		{
+			uint64_t depthPassedFragments{};
+			uint64_t shadedPixels{};
+		};
+		const ShadingStatistics& GetShadingStatistics() const;
+		void PrintShadingStatistics() const;
+
+		// Wall time of every stage of the last frame, in milliseconds
+		// Statistics gathering, unlocking and waiting for a free ring buffer count towards present
+		struct FrameTimings
+		{
+			double clearMs{};
+			double transformMs{};
+			double setupMs{};
+			double rasterMs{};
+			double deferredShadeMs{};
+			double resolveMs{};
+			double upscaleMs{};
+			double presentMs{};
+			double totalMs{};
+		};
+		const FrameTimings& GetFrameTimings() const;
 
 	private:
 		SDL_Window* m_pWindow{};
@@ -49,7 +123,75 @@ namespace dae
 		SDL_Surface* m_pBackBuffer{ nullptr };
 		uint32_t* m_pBackBufferPixels{};
 
-		float* m_pDepthBufferPixels;
+		// Without a ring every frame goes into this one, with a ring the backBuffer is the ring buffer of this frame
+		// It is the window surface itself when the resolve can pack its format, so nothing gets copied
+		SDL_Surface* m_pSyncBackBuffer{ nullptr };
+		PresentQueue* m_pPresentQueue{ nullptr };
+		static constexpr uint32_t m_MaxPresentBufferCount{ 3 };
+
+		// Depth is stored as a key in the selected format, smaller is always closer
+		// Float32 keeps z/w, ReversedFloat32 -(1 - z/w) for precision near the far plane, the unorm formats z/w scaled to their range
+		enum class DepthFormat
+		{
+			Float32,
+			ReversedFloat32,
+			Unorm24,
+			Unorm16
+		};
+		DepthFormat m_DepthFormat{ DepthFormat::Float32 };
+		float m_DepthClearValue{ FLT_MAX };
+
+		template<DepthFormat format>
+		using DepthStorage = std::conditional_t<format == DepthFormat::Unorm16, uint16_t, std::conditional_t<format == DepthFormat::Unorm24, uint32_t, float>>;
+
+		template<DepthFormat format>
+		static constexpr float GetDepthScale() { return format == DepthFormat::Unorm16 ? 65535.f : 16777215.f; }
+
+		std::byte* m_pDepthBufferPixels{ nullptr };
+
+		// Per-tile depth compression, a tile only writes per-pixel depth once something needs it
+		// Until then it is either still cleared or covered by a single triangle's depth plane
+		enum class TileDepthState : uint8_t
+		{
+			Expanded,
+			Cleared,
+			Planar
+		};
+		bool m_UseDepthCompression{ false };
+		std::vector<TileDepthState> m_TileDepthStates{};
+		std::vector<uint32_t> m_TilePlanarTriangles{};
+
+		// Linear HDR color, one plane per channel, resolved into the backBuffer at the end of the frame
+		float* m_pColorBufferPixels{ nullptr };
+
+		// Lazy clear, a tile's buffers are only initialized once something touches it this frame
+		ColorRGB m_ClearColor{};
+		uint32_t m_ClearPixel{};
+		std::vector<uint8_t> m_TileCleared{};
+
+		// Dynamic resolution, the scale follows the measured frame cost
+		// Cost is estimated at full resolution from the pixel count and smoothed over frames
+		bool m_UseDynamicResolution{ false };
+		float m_ResolutionScale{ 1.f };
+		float m_TargetFrameMs{ 1000.f / 60.f };
+		float m_FullResolutionFrameMs{};
+		static constexpr float m_MinResolutionScale{ 0.5f };
+		static constexpr float m_FrameCostSmoothing{ 0.2f };
+		static constexpr float m_ResolutionScaleDeadband{ 0.02f };
+
+		// Where the color resolve packs to, the scaled buffer when the frame gets upscaled
+		// Both share the backBuffer's 32-bit pixel format
+		SDL_Surface* m_pRenderTarget{ nullptr };
+		SDL_Surface* m_pScaledBuffer{ nullptr };
+
+		// Bilinear upscale, source columns and 8-bit weight per window column, weights repeated for all 4 channels
+		static constexpr int m_UpscaleRowsPerJob{ 16 };
+		std::vector<int32_t> m_UpscaleSourceX0{};
+		std::vector<int32_t> m_UpscaleSourceX1{};
+		std::vector<uint16_t> m_UpscaleWeightsX{};
+
+		static constexpr int m_SrgbLutSize{ 4096 };
+		std::vector<uint32_t> m_SrgbLut{};
 
 		Camera* m_pCamera{ nullptr };
 
@@ -61,6 +203,9 @@ namespace dae
 		Texture* m_pSpecularTexture{ nullptr };
 		Texture* m_pGlossinessTexture{ nullptr };
 
+		// Buffers are sized for the window, frames render into the top-left m_Width x m_Height of them
+		int m_WindowWidth{};
+		int m_WindowHeight{};
 		int m_Width{};
 		int m_Height{};
 
@@ -71,9 +216,253 @@ namespace dae
 		bool m_ShowDepthBuffer{ false };
 		bool m_UseNormalMap{ true };
 		bool m_ShowBoundingBoxes{ false };
+		bool m_UseSimd{ true };
+		bool m_UseVisibilityBuffer{ false };
+		bool m_UseSrgbOutput{ false };
+
+		// Coarse shading needs the final fragment of every pixel, so it shades from the visibility buffer as well
+		// Set at the start of every frame
+		bool m_UseDeferredShading{ false };
+
+		// Variable-rate shading, coverage and depth stay per pixel
+		// Adaptive picks a rate per block from last frame's luminance, Coarse shades every 2x2 pixels once
+		enum class ShadingRateMode
+		{
+			Full,
+			Adaptive,
+			Coarse
+		};
+		ShadingRateMode m_ShadingRateMode{ ShadingRateMode::Full };
+
+		// Rate image, one rate per block: bit 0 halves the rate along x, bit 1 along y, a halved rate shares a shade between 2 pixels
+		static constexpr int m_ShadingRateBlockSize{ 8 };
+		static constexpr uint8_t m_CoarseShadingRateX{ 1 };
+		static constexpr uint8_t m_CoarseShadingRateY{ 2 };
+		static constexpr int m_CoarseCellSize{ 2 };
+		static constexpr int m_MaxShadingCellPixelCount{ 4 };
+		int m_ShadingRateBlockCountX{};
+		int m_ShadingRateBlockCountY{};
+		std::vector<uint8_t> m_ShadingRates{};
+
+		// Largest luminance step per pixel that still gets shaded at a lower rate, and the one that takes a coarse block back to full rate
+		static constexpr float m_ShadingRateThreshold{ 1.f / 64.f };
+		static constexpr float m_ShadingRateLeaveThreshold{ 3.f / 64.f };
+
+		// Heatmaps, counts per pixel or wall time per tile, mapped from black over blue, green and yellow to red
+		// Overdraw counts fragments that passed the depth test, DepthFailures the ones that reached the per-pixel test and failed
+		// Blocks HiZ rejects never reach that test, so they don't show up as failures
+		enum class HeatmapMode
+		{
+			Off,
+			Overdraw,
+			DepthFailures,
+			TileCost
+		};
+		HeatmapMode m_HeatmapMode{ HeatmapMode::Off };
+
+		// Counting goes through the scalar pixel loops, set at the start of every frame
+		bool m_IsCountingFragments{ false };
+		std::vector<uint16_t> m_HeatmapCounts{};
+		std::vector<uint64_t> m_TileCostNanoseconds{};
+
+		// Count that maps to full heat
+		static constexpr int m_HeatmapMaxCount{ 8 };
 
 		float m_AccumulatedTime{};
 
+		// Fetched once per frame for the view directions
+		Vector3 m_CameraOrigin{};
+
+		// Tiles
+		struct EdgeFunction
+		{
+			// value = a * x + b * y + c, in sub-pixel fixed point, positive inside
+			int64_t a{};
+			int64_t b{};
+			int64_t c{};
+
+			// 0 for top and left edges, -1 otherwise, already added to c
+			int64_t bias{};
+
+			// Value change per pixel step
+			int64_t stepX{};
+			int64_t stepY{};
+		};
+
+		struct AttributePlane
+		{
+			// value = c + b * dy + a * dx, in pixels from the center of the triangle's first pixel
+			float a{};
+			float b{};
+			float c{};
+
+			float Evaluate(float dx, float dy) const { return c + b * dy + a * dx; }
+		};
+
+		struct TriangleSetup
+		{
+			// Edge i is opposite of vertex i
+			EdgeFunction edges[3]{};
+
+			// Screen-space planes, attributes are divided by w so they stay linear
+			AttributePlane zDepth{};
+			AttributePlane inverseWDepth{};
+			AttributePlane uv[2]{};
+			AttributePlane normal[3]{};
+			AttributePlane tangent[3]{};
+			AttributePlane viewDirection[3]{};
+
+			float minZDepth{};
+			float maxZDepth{};
+
+			// Pixel bounds, maxX and maxY are exclusive
+			int minX{};
+			int minY{};
+			int maxX{};
+			int maxY{};
+
+			// Small triangles only, coverage of the stamp at minX, minY, row by row with a bit per pixel or per sample
+			bool isSmall{ false };
+			uint64_t stampCoverage{};
+		};
+
+		static constexpr int m_TileSize{ 64 };
+
+		// Triangles whose bounds fit a 4x4 stamp get their coverage during setup, 4x4 pixels of 4 samples fill the 64-bit mask
+		static constexpr int m_StampSize{ 4 };
+
+		// 28.4 sub-pixel precision
+		static constexpr int m_SubPixelBits{ 4 };
+		static constexpr int m_SubPixelSteps{ 1 << m_SubPixelBits };
+		int m_TileCountX{};
+		int m_TileCountY{};
+
+		// 4x MSAA, coverage and depth per sample, shading once per pixel and triangle
+		// Samples of a pixel sit next to each other, the color resolve averages them into the color planes
+		bool m_UseMsaa{ false };
+		static constexpr int m_SampleCount{ 4 };
+		static constexpr int m_FullCoverageMask{ (1 << m_SampleCount) - 1 };
+
+		// Rotated grid, in sub-pixel steps from the pixel center
+		static constexpr int m_SampleOffsetsX[m_SampleCount]{ -m_SubPixelSteps / 8, m_SubPixelSteps * 3 / 8, -m_SubPixelSteps * 3 / 8, m_SubPixelSteps / 8 };
+		static constexpr int m_SampleOffsetsY[m_SampleCount]{ -m_SubPixelSteps * 3 / 8, -m_SubPixelSteps / 8, m_SubPixelSteps / 8, m_SubPixelSteps * 3 / 8 };
+		static constexpr int m_MaxSampleOffset{ m_SubPixelSteps * 3 / 8 };
+
+		std::byte* m_pSampleDepthPixels{ nullptr };
+		float* m_pSampleColorPixels{ nullptr };
+
+		// Clipping happens in clip space against near, far and a guard band around the screen
+		// Triangles that only stick out of the screen are clamped by the rasterizer instead
+		static constexpr int m_ClipPlaneCount{ 6 };
+		static constexpr uint16_t m_ClipPlaneMask{ (1 << m_ClipPlaneCount) - 1 };
+		static constexpr int m_MaxClippedVertices{ 3 + m_ClipPlaneCount };
+
+		// Keeps sub-pixel coordinates far away from overflowing the edge functions
+		static constexpr int m_GuardBandPixels{ 4096 };
+		float m_GuardBandX{};
+		float m_GuardBandY{};
+
+		// Post-transform vertices as a structure of arrays, one contiguous stream per component
+		// Positions are in clip space, normals and tangents in world space
+		struct VertexStreams
+		{
+			std::vector<float> positionX{};
+			std::vector<float> positionY{};
+			std::vector<float> positionZ{};
+			std::vector<float> positionW{};
+			std::vector<float> u{};
+			std::vector<float> v{};
+			std::vector<float> normalX{};
+			std::vector<float> normalY{};
+			std::vector<float> normalZ{};
+			std::vector<float> tangentX{};
+			std::vector<float> tangentY{};
+			std::vector<float> tangentZ{};
+
+			// Perspective divide, raster x/y, depth after the divide and 1/w
+			std::vector<float> rasterX{};
+			std::vector<float> rasterY{};
+			std::vector<float> rasterZ{};
+			std::vector<float> inverseW{};
+
+			size_t GetSize() const { return positionX.size(); }
+			Vector4 GetPosition(uint32_t idx) const { return Vector4{ positionX[idx], positionY[idx], positionZ[idx], positionW[idx] }; }
+
+			// Keeps the capacity, so steady frames don't allocate
+			void Resize(size_t size);
+
+			// Only used by the clipper, which works on whole vertices
+			VS_OUPUT Gather(uint32_t idx) const;
+			uint32_t PushBack(const VS_OUPUT& vertex);
+		};
+
+		VertexStreams m_VerticesOut{};
+
+		// Object-space face planes, culling happens before the vertex transform
+		// The screen-space area sign still decides for triangles too close to call
+		struct FacePlane
+		{
+			Vector3 normal{};
+			float distance{};
+		};
+
+		static constexpr float m_FaceCullingEpsilon{ 1e-4f };
+		std::vector<std::vector<FacePlane>> m_MeshFacePlanes{};
+
+		// Per mesh, allocated from the frame arena
+		uint8_t* m_pTriangleVisible{ nullptr };
+		uint8_t* m_pVertexUsed{ nullptr };
+
+		// Vertices per transform job, large meshes get split over the workers
+		static constexpr uint32_t m_VertexBatchSize{ 4096 };
+
+		// Bins are lists of fixed-size chunks from the frame arena, so filling them never reallocates
+		static constexpr int m_BinChunkSize{ 60 };
+		struct TileBinChunk
+		{
+			uint32_t triangleIndices[m_BinChunkSize];
+			uint32_t count;
+			TileBinChunk* pNext;
+		};
+
+		struct TileBin
+		{
+			TileBinChunk* pFirstChunk{ nullptr };
+			TileBinChunk* pLastChunk{ nullptr };
+		};
+
+		std::vector<TriangleSetup> m_Triangles{};
+		std::vector<TileBin> m_TileBins{};
+
+		ThreadPool* m_pThreadPool{ nullptr };
+
+		// Backs all transient per-frame data, reset at the start of every frame
+		FrameArena* m_pFrameArena{ nullptr };
+
+		std::vector<ShadingStatistics> m_TileStatistics{};
+		ShadingStatistics m_ShadingStatistics{};
+		FrameTimings m_FrameTimings{};
+
+		// Visibility buffer, triangle of the closest fragment per pixel, its planes give back the rest
+		static constexpr uint32_t m_InvalidTriangleIdx{ UINT32_MAX };
+		std::vector<uint32_t> m_VisibilityTriangleIds{};
+
+		// HiZ, depth range per 8x8 block with a max per tile on top
+		struct HiZBlock
+		{
+			float minDepth{ FLT_MAX };
+			float maxDepth{ FLT_MAX };
+		};
+
+		static constexpr int m_HiZBlockSize{ 8 };
+		static constexpr float m_HiZDepthMargin{ 1e-5f };
+		int m_HiZBlockCountX{};
+		int m_HiZBlockCountY{};
+
+		std::vector<HiZBlock> m_HiZBlocks{};
+		std::vector<float> m_HiZTileMaxDepths{};
+		std::vector<uint8_t> m_HiZTileDirty{};
+
 		enum class shadingModes
 		{
 			ObservedArea,
@@ -84,7 +473,123 @@ namespace dae
 		shadingModes m_CurrentShadingMode{ shadingModes::Combined };
 
 		//Function that transforms the vertices from the mesh from World space to Screen space
-		void VertexTransformationFunction(const std::vector<VS_INPUT>& vertices_in, std::vector<VS_OUPUT>& vertices_out, const Matrix& worldMatrix) const; //W1 Version
+		void VertexTransformationFunction(const std::vector<VS_INPUT>& vertices_in, VertexStreams& vertices_out, const Matrix& worldMatrix) const; //W1 Version
+		void TransformVertices(const std::vector<VS_INPUT>& vertices_in, VertexStreams& vertices_out, const Matrix& worldViewProjectionMatrix, const Matrix& worldMatrix, size_t firstIdx, size_t lastIdx) const;
+#if defined(__AVX2__)
+		size_t TransformVerticesSimd(const std::vector<VS_INPUT>& vertices_in, VertexStreams& vertices_out, const Matrix& worldViewProjectionMatrix, const Matrix& worldMatrix, size_t firstIdx, size_t lastIdx) const;
+#endif
+		void ProjectVertex(VertexStreams& vertices, size_t idx) const;
+		uint32_t PushClippedVertex(const VS_OUPUT& vertex);
+
+		// Triangle setup and binning, then per-tile rasterization
+		size_t GetTriangleCount(const Mesh& mesh) const;
+		void GetTriangleIndices(const Mesh& mesh, size_t triangleIdx, uint32_t indices[3]) const;
+		std::vector<FacePlane> CreateFacePlanes(const Mesh& mesh) const;
+		void CullTriangles(const Mesh& mesh, const std::vector<FacePlane>& facePlanes, const Matrix& worldMatrix);
+		bool IsCulled(int64_t totalParallelogramArea) const;
+
+		void SetupTriangles(const Mesh& mesh);
+		void SetupTriangle(uint32_t firstIndex, uint32_t secondIndex, uint32_t thirdIndex);
+		uint64_t GetStampCoverage(const TriangleSetup& triangle) const;
+		void AddToBin(TileBin& tileBin, uint32_t triangleIdx);
+
+		// Outcode bits 0-5 are the clip planes, 6-9 the screen sides
+		uint16_t ComputeOutCode(const Vector4& position) const;
+		float GetClipDistance(const Vector4& position, int planeIdx) const;
+		int ClipTriangle(const VS_OUPUT vertices[3], uint16_t clipPlanes, VS_OUPUT* pClippedVertices) const;
+		static VS_OUPUT InterpolateVertex(const VS_OUPUT& from, const VS_OUPUT& to, float t);
+		void GetTileBounds(uint32_t tileIdx, int& minX, int& minY, int& maxX, int& maxY) const;
+		void RasterizeTile(uint32_t tileIdx);
+		void ResolveTile(uint32_t tileIdx);
+
+		// Shades every triangle left in the cell once, returns the number of shades
+		uint64_t ShadeCell(int minX, int minY, int maxX, int maxY);
+		void UpdateShadingRates(uint32_t tileIdx);
+
+		// Depth keys, the rasterizer only ever compares and stores these
+		float GetDepthKey(const VertexStreams& vertices, uint32_t idx) const;
+		float DecodeDepth(float depthKey) const;
+
+		// Templated on the depth format, so the pixel loops don't branch on it
+		template<DepthFormat format>
+		uint64_t RasterizeBin(uint32_t tileIdx, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+		template<DepthFormat format>
+		void ClearTile(uint32_t tileIdx, int minX, int minY, int maxX, int maxY);
+		template<DepthFormat format>
+		void FillTileDepth(uint32_t tileIdx);
+
+		// Return the number of fragments that passed the depth test
+		template<DepthFormat format>
+		uint32_t RasterizeTriangle(uint32_t triangleIdx, int minX, int minY, int maxX, int maxY);
+		bool IsCoveringTile(const TriangleSetup& triangle, int tileIdx, int minX, int minY, int maxX, int maxY) const;
+		uint32_t RasterizeCoveredTile(const TriangleSetup& triangle, uint32_t triangleIdx, int tileIdx, float minZDepth, float maxZDepth);
+		template<DepthFormat format>
+		uint32_t RasterizeStamp(const TriangleSetup& triangle, uint32_t triangleIdx, int tileIdx, int minX, int minY, int maxX, int maxY);
+		template<DepthFormat format>
+		uint32_t RasterizeBlock(const TriangleSetup& triangle, uint32_t triangleIdx, int minX, int minY, int maxX, int maxY, bool passesDepthTest);
+		template<DepthFormat format>
+		uint32_t RasterizeBlockMsaa(const TriangleSetup& triangle, uint32_t triangleIdx, int minX, int minY, int maxX, int maxY, bool passesDepthTest);
+#if defined(__AVX2__)
+		template<DepthFormat format>
+		uint32_t RasterizeBlockSimd(const TriangleSetup& triangle, uint32_t triangleIdx, int minX, int minY, int maxX, int maxY, bool passesDepthTest);
+		template<DepthFormat format>
+		uint32_t RasterizeBlockMsaaSimd(const TriangleSetup& triangle, uint32_t triangleIdx, int minX, int minY, int maxX, int maxY, bool passesDepthTest);
+		template<DepthFormat format>
+		static __m256 QuantizeDepthSimd(__m256 depthKey);
+		template<DepthFormat format>
+		static __m256 LoadDepthSimd(const std::byte* pDepthBuffer, int depthIndex, __m256i inRange, int laneCount);
+		template<DepthFormat format>
+		static void StoreDepthSimd(std::byte* pDepthBuffer, int depthIndex, __m256i passLanes, int passMask, int laneCount, __m256 depthKey);
+#endif
+		// Depth buffers are indexed per pixel, sample depth buffers per sample
+		template<DepthFormat format>
+		static float QuantizeDepth(float depthKey);
+		template<DepthFormat format>
+		static float LoadDepth(const std::byte* pDepthBuffer, int depthIndex);
+		template<DepthFormat format>
+		static void StoreDepth(std::byte* pDepthBuffer, int depthIndex, float depthKey);
+
+		template<DepthFormat format>
+		void UpdateHiZBlock(HiZBlock& block, int blockMinX, int blockMinY);
+		float GetTileMaxDepth(int tileIdx);
+		float GetTileMinDepth(int tileIdx) const;
+		void ShadePixel(const TriangleSetup& triangle, int px, int py, float depthKey);
+		ColorRGB ShadeFragment(const TriangleSetup& triangle, float dx, float dy, float depthKey) const;
+		void WriteColor(int pixelIndex, const ColorRGB& color);
+
+		// MSAA, one shade per pixel written to every sample in sampleMask
+		int GetCoverageMask(const TriangleSetup& triangle, int px, int py) const;
+		void ShadeSamples(const TriangleSetup& triangle, int px, int py, int coverageMask, int sampleMask);
+		void WriteSampleColors(int pixelIndex, int sampleMask, const ColorRGB& color);
+		void ResolveSamples(int minX, int minY, int maxX, int maxY);
+#if defined(__AVX2__)
+		int ResolveSamplesRowSimd(int rowIndex, int minX, int maxX);
+#endif
+
+		// Internal resolution, everything sized by it follows
+		void SetRenderSize(int width, int height);
+		void UpdateResolutionScale(double frameMs);
+
+		// Bilinear, from the render target to the backBuffer
+		void UpscaleRows(int firstRow, int lastRow) const;
+		void GetUpscaleSourceRow(int row, int& firstSourceRow, int& secondSourceRow, uint16_t& weight) const;
+#if defined(__AVX2__)
+		int UpscaleRowSimd(const uint32_t* pFirstSourceRow, const uint32_t* pSecondSourceRow, uint32_t* pRow, uint16_t weightY) const;
+#endif
+
+		// Clamp or encode, then pack into the render target's pixel format
+		void ResolveColorTile(uint32_t tileIdx);
+#if defined(__AVX2__)
+		int ResolveRowSimd(int rowIndex, uint32_t* pRow, int minX, int maxX) const;
+#endif
+		uint32_t PackColor(ColorRGB color) const;
+		uint8_t EncodeChannel(float value) const;
+
+		// Heatmaps overwrite the resolved tile, tile cost is relative to the most expensive tile of the frame
+		void CountFragment(int pixelIndex, bool passedDepthTest);
+		void WriteHeatmapTile(uint32_t tileIdx, uint64_t maxTileCost);
+		static ColorRGB GetHeatmapColor(float heat);
+		const char* GetHeatmapName() const;
 
 		// HELPERS
 		bool IsValueBetweenBoundaries(float value, float minBound = 0.0f, float maxBound = 1.0f) const;
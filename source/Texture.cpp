@@ -1,9 +1,22 @@
 #include "pch.h"
 #include "Texture.h"
 
+#if !defined(DAE_HEADLESS)
 Texture::Texture(ID3D11Device* pDevice, const char* fileName)
 {
-	LoadTexture(pDevice, fileName);
+	if (LoadSurface(fileName)) LoadTexture(pDevice);
+}
+#endif
+
+Texture::Texture(const char* fileName)
+{
+	LoadSurface(fileName);
+}
+
+Texture::Texture(SDL_Surface* pSurface)
+	: m_pSurface{ pSurface }
+	, m_pSurfacePixels{ pSurface != nullptr ? static_cast<uint32_t*>(pSurface->pixels) : nullptr }
+{
 }
 
 Texture::~Texture()
@@ -11,10 +24,12 @@ Texture::~Texture()
 	ReleaseResource();
 }
 
+#if !defined(DAE_HEADLESS)
 ID3D11ShaderResourceView* Texture::GetShaderResourceView() const
 {
 	return m_pShaderResourceView;
 }
+#endif
 
 dae::ColorRGB Texture::Sample(const dae::Vector2& uv) const
 {
@@ -42,19 +57,31 @@ dae::ColorRGB Texture::Sample(const dae::Vector2& uv) const
 	return desiredColor;
 }
 
-void Texture::LoadTexture(ID3D11Device* pDevice, const char* fileName)
+bool Texture::LoadSurface(const char* fileName)
 {
+	DAE_PROFILE_SCOPE("Texture::LoadSurface");
+
 	// Load File
 	SDL_Surface* pSurface{ IMG_Load(fileName) };
 	if (pSurface == NULL)
 	{
 		std::cout << "Failed to Load File" << '\n';
-		return;
+		return false;
 	}
 
 	m_pSurface = pSurface;
 	m_pSurfacePixels = (uint32_t*)pSurface->pixels;
 
+	return true;
+}
+
+#if !defined(DAE_HEADLESS)
+void Texture::LoadTexture(ID3D11Device* pDevice)
+{
+	DAE_PROFILE_SCOPE("Texture::LoadTexture");
+
+	SDL_Surface* pSurface{ m_pSurface };
+
 	// Create Texture
 	DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
 	D3D11_TEXTURE2D_DESC desc{};
@@ -97,9 +124,11 @@ void Texture::LoadTexture(ID3D11Device* pDevice, const char* fileName)
 		return;
 	}
 }
+#endif
 
 void Texture::ReleaseResource()
 {
+#if !defined(DAE_HEADLESS)
 	if (m_pShaderResourceView)
 	{
 		m_pShaderResourceView->Release();
@@ -111,6 +140,7 @@ void Texture::ReleaseResource()
 		m_pTexture->Release();
 		m_pTexture = nullptr;
 	}
+#endif
 
 	if (m_pSurface)
 	{
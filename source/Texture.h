@@ -7,7 +7,13 @@ class Texture final
 {
 public:
 	// Constructor and Destructor
+#if !defined(DAE_HEADLESS)
 	explicit Texture(ID3D11Device* pDevice, const char* fileName);
+#endif
+	// CPU only, for the software renderer
+	explicit Texture(const char* fileName);
+	// Takes ownership of a 32-bit surface, for generated textures
+	explicit Texture(SDL_Surface* pSurface);
 	~Texture();
 
 	// Rule Of Five
@@ -17,18 +23,26 @@ public:
 	Texture& operator=(Texture&&) noexcept = delete;
 
 	// Public
+#if !defined(DAE_HEADLESS)
 	ID3D11ShaderResourceView* GetShaderResourceView() const;
+#endif
 	dae::ColorRGB Sample(const dae::Vector2& uv) const;
+	bool IsLoaded() const { return m_pSurface != nullptr; }
 
 private:
+#if !defined(DAE_HEADLESS)
 	ID3D11Resource* m_pTexture{ nullptr };
 	ID3D11ShaderResourceView* m_pShaderResourceView{ nullptr };
+#endif
 
 	SDL_Surface* m_pSurface{ nullptr };
 	uint32_t* m_pSurfacePixels{ nullptr };
 
 	// HELPER
-	void LoadTexture(ID3D11Device* pDevice, const char* fileName);
+	bool LoadSurface(const char* fileName);
+#if !defined(DAE_HEADLESS)
+	void LoadTexture(ID3D11Device* pDevice);
+#endif
 	void ReleaseResource();
 };
 
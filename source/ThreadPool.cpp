@@ -0,0 +1,97 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+namespace dae
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		// Calling thread is worker 0, so only spawn the rest
+		const uint32_t workerCount{ std::max(threadCount, 1u) - 1 };
+
+		m_Workers.reserve(workerCount);
+		for (uint32_t idx{}; idx < workerCount; ++idx)
+		{
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, idx + 1);
+		}
+	}
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_StartCondition.notify_all();
+
+		for (auto& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::Dispatch(uint32_t jobCount, JobFunction pJobFunction, const void* pJob)
+	{
+		// Nothing to share, run on the calling thread
+		if (m_Workers.empty() || jobCount <= 1)
+		{
+			for (uint32_t jobIdx{}; jobIdx < jobCount; ++jobIdx)
+			{
+				pJobFunction(pJob, jobIdx, 0);
+			}
+			return;
+		}
+
+		// Publish work
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			m_pJobFunction = pJobFunction;
+			m_pJob = pJob;
+			m_JobCount = jobCount;
+			m_NextJob.store(0);
+			m_BusyWorkers = static_cast<uint32_t>(m_Workers.size());
+			++m_Generation;
+		}
+		m_StartCondition.notify_all();
+
+		// Help out
+		RunJobs(0);
+
+		// Wait for the workers to drain
+		std::unique_lock<std::mutex> lock{ m_Mutex };
+		m_DoneCondition.wait(lock, [this]() { return m_BusyWorkers == 0; });
+	}
+
+	void ThreadPool::RunJobs(uint32_t threadIdx)
+	{
+		for (uint32_t jobIdx{ m_NextJob.fetch_add(1) }; jobIdx < m_JobCount; jobIdx = m_NextJob.fetch_add(1))
+		{
+			m_pJobFunction(m_pJob, jobIdx, threadIdx);
+		}
+	}
+
+	void ThreadPool::WorkerLoop(uint32_t threadIdx)
+	{
+		DAE_PROFILE_THREAD_NAME("Worker " + std::to_string(threadIdx));
+
+		uint64_t lastGeneration{};
+		while (true)
+		{
+			// Wait for new work
+			{
+				std::unique_lock<std::mutex> lock{ m_Mutex };
+				m_StartCondition.wait(lock, [&]() { return m_IsStopping || m_Generation != lastGeneration; });
+
+				if (m_IsStopping) return;
+				lastGeneration = m_Generation;
+			}
+
+			RunJobs(threadIdx);
+
+			// Report back
+			{
+				std::lock_guard<std::mutex> lock{ m_Mutex };
+				--m_BusyWorkers;
+				if (m_BusyWorkers == 0) m_DoneCondition.notify_one();
+			}
+		}
+	}
+}
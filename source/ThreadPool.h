@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	class ThreadPool final
+	{
+	public:
+		// Constructor and Destructor
+		// threadCount includes the calling thread, so 1 means no extra workers
+		explicit ThreadPool(uint32_t threadCount);
+		~ThreadPool();
+
+		// Rule of Five
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		// Public functions
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+
+		// Calls job(jobIdx, threadIdx) for every jobIdx in [0, jobCount) and blocks until all are done
+		// The calling thread takes part as threadIdx 0
+		template<typename Job>
+		void ParallelFor(uint32_t jobCount, const Job& job)
+		{
+			Dispatch(jobCount, &InvokeJob<Job>, &job);
+		}
+
+	private:
+		using JobFunction = void(*)(const void* pJob, uint32_t jobIdx, uint32_t threadIdx);
+
+		std::vector<std::thread> m_Workers{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_StartCondition{};
+		std::condition_variable m_DoneCondition{};
+
+		JobFunction m_pJobFunction{ nullptr };
+		const void* m_pJob{ nullptr };
+		uint32_t m_JobCount{};
+		std::atomic<uint32_t> m_NextJob{};
+
+		uint64_t m_Generation{};
+		uint32_t m_BusyWorkers{};
+		bool m_IsStopping{ false };
+
+		// Member Functions
+		void Dispatch(uint32_t jobCount, JobFunction pJobFunction, const void* pJob);
+		void RunJobs(uint32_t threadIdx);
+		void WorkerLoop(uint32_t threadIdx);
+
+		template<typename Job>
+		static void InvokeJob(const void* pJob, uint32_t jobIdx, uint32_t threadIdx)
+		{
+			(*static_cast<const Job*>(pJob))(jobIdx, threadIdx);
+		}
+	};
+}
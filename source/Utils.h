@@ -13,6 +13,8 @@ namespace dae
 #pragma warning(disable : 4505) //Warning unreferenced local function
 		static bool ParseOBJ(const std::string& filename, std::vector<dae::VS_INPUT>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
 		{
+			DAE_PROFILE_SCOPE("Utils::ParseOBJ");
+
 			std::ifstream file(filename);
 			if (!file)
 				return false;
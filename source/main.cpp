@@ -36,6 +36,8 @@ int main(int argc, char* args[])
 	if (!pWindow)
 		return 1;
 
+	DAE_PROFILE_THREAD_NAME("Main");
+
 	//Initialize "framework"
 	const auto pTimer = new Timer();
 	const auto pRenderer = new Renderer(pWindow);
@@ -100,6 +102,50 @@ int main(int argc, char* args[])
 					pRenderer->ToggleUniformClearColor();
 					break;
 
+				case SDLK_1:
+					pRenderer->ToggleVisibilityBuffer();
+					break;
+
+				case SDLK_2:
+					pRenderer->ToggleSrgbOutput();
+					break;
+
+				case SDLK_3:
+					pRenderer->ToggleDepthFormat();
+					break;
+
+				case SDLK_4:
+					pRenderer->ToggleDepthCompression();
+					break;
+
+				case SDLK_5:
+					pRenderer->ToggleTraceCapture();
+					break;
+
+				case SDLK_6:
+					pRenderer->ToggleMsaa();
+					break;
+
+				case SDLK_7:
+					pRenderer->ToggleDynamicResolution();
+					break;
+
+				case SDLK_8:
+					pRenderer->ToggleShadingRate();
+					break;
+
+				case SDLK_9:
+					pRenderer->TogglePresentBuffers();
+					break;
+
+				case SDLK_0:
+					pRenderer->ToggleHeatmap();
+					break;
+
+				case SDLK_x:
+					pRenderer->ExportSoftwareFrame();
+					break;
+
 				case SDLK_F11:
 					printFPS = !printFPS;
 
@@ -136,6 +182,7 @@ int main(int argc, char* args[])
 			{
 				printTimer = 0.f;
 				std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+				pRenderer->PrintStatistics();
 			}
 		}
 	}
@@ -9,16 +9,21 @@
 
 // SDL Headers
 #include "SDL.h"
-#include "SDL_syswm.h"
 #include "SDL_surface.h"
 #include "SDL_image.h"
 
+// Headless builds only have the software renderer, no window and no DirectX
+#if !defined(DAE_HEADLESS)
+#include "SDL_syswm.h"
+
 // DirectX Headers
 #include <dxgi.h>
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <d3dx11effect.h>
+#endif
 
 // Framework Headers
 #include "Timer.h"
-#include "Math.h"
\ No newline at end of file
+#include "Math.h"
+#include "Profiler.h"
\ No newline at end of file
@@ -0,0 +1,732 @@
+#include "pch.h"
+
+#undef main
+#include "SoftwareRenderer.h"
+#include "Texture.h"
+#include "Camera.h"
+#include "Utils.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+
+using namespace dae;
+
+// Golden-image regression tests for the software renderer
+// Every scene is rendered in every shading mode, culling mode and normal map setting and compared to a stored reference
+// The fast paths (AVX2, threading, visibility buffer, depth compression) have to match the default render exactly
+
+#if !defined(DUALRASTERIZER_SOURCE_DIR)
+#define DUALRASTERIZER_SOURCE_DIR "."
+#endif
+
+struct TestOptions
+{
+	std::string referenceDirectory{ DUALRASTERIZER_SOURCE_DIR "/tests/golden" };
+	std::string vehiclePath{ DUALRASTERIZER_SOURCE_DIR "/source/Resources/vehicle.obj" };
+
+	// Failed cases write their image and a diff in here, the generated scenes' OBJ files end up here too
+	std::string outputDirectory{ "golden_output" };
+	std::string resultsPath{ "golden_results.csv" };
+
+	// Only cases with this in their name
+	std::string filter{};
+
+	// Largest per-channel difference that still counts as equal, and the fraction of pixels that may go over it
+	int channelTolerance{ 2 };
+	float maxBadPixelFraction{ 0.001f };
+
+	int timingFrameCount{ 5 };
+	bool updateReferences{ false };
+};
+
+// Small enough to keep the references in the repository, big enough for a few tiles
+constexpr int g_ImageWidth{ 192 };
+constexpr int g_ImageHeight{ 144 };
+
+// Fixed rather than the core count, so the worker pool gets tested on single-core machines too
+constexpr uint32_t g_ThreadCount{ 4 };
+
+// -- Images -- //
+
+struct Image
+{
+	int width{};
+	int height{};
+	std::vector<uint8_t> pixels{};		// RGB, row by row
+};
+
+Image CaptureBackBuffer(const SoftwareRenderer& softwareRenderer)
+{
+	const SDL_Surface* pBackBuffer{ softwareRenderer.GetBackBuffer() };
+
+	Image image{ pBackBuffer->w, pBackBuffer->h };
+	image.pixels.resize(static_cast<size_t>(image.width) * image.height * 3);
+
+	for (int py{}; py < image.height; ++py)
+	{
+		const uint32_t* pRow{ reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(pBackBuffer->pixels) + py * pBackBuffer->pitch) };
+		for (int px{}; px < image.width; ++px)
+		{
+			uint8_t* pPixel{ &image.pixels[(static_cast<size_t>(py) * image.width + px) * 3] };
+			SDL_GetRGB(pRow[px], pBackBuffer->format, &pPixel[0], &pPixel[1], &pPixel[2]);
+		}
+	}
+
+	return image;
+}
+
+// PNG through SDL_image, lossless and a fraction of the size of raw pixels
+bool ReadPng(const std::string& fileName, Image& image)
+{
+	SDL_Surface* pLoadedSurface{ IMG_Load(fileName.c_str()) };
+	if (pLoadedSurface == nullptr) return false;
+
+	// Whatever layout the file decodes to, the pixels get compared as RGB bytes
+	SDL_Surface* pSurface{ SDL_ConvertSurfaceFormat(pLoadedSurface, SDL_PIXELFORMAT_RGB24, 0) };
+	SDL_FreeSurface(pLoadedSurface);
+	if (pSurface == nullptr) return false;
+
+	image.width = pSurface->w;
+	image.height = pSurface->h;
+	image.pixels.resize(static_cast<size_t>(image.width) * image.height * 3);
+	for (int py{}; py < image.height; ++py)
+	{
+		const uint8_t* pRow{ static_cast<const uint8_t*>(pSurface->pixels) + py * pSurface->pitch };
+		std::copy(pRow, pRow + image.width * 3, &image.pixels[static_cast<size_t>(py) * image.width * 3]);
+	}
+
+	SDL_FreeSurface(pSurface);
+	return true;
+}
+
+bool WritePng(const std::string& fileName, const Image& image)
+{
+	// Wraps the pixels, SDL doesn't copy or free them
+	SDL_Surface* pSurface{ SDL_CreateRGBSurfaceWithFormatFrom(const_cast<uint8_t*>(image.pixels.data()), image.width, image.height,
+		24, image.width * 3, SDL_PIXELFORMAT_RGB24) };
+	if (pSurface == nullptr) return false;
+
+	const bool isWritten{ IMG_SavePNG(pSurface, fileName.c_str()) == 0 };
+	SDL_FreeSurface(pSurface);
+	return isWritten;
+}
+
+struct Comparison
+{
+	int maxChannelDifference{};
+	int badPixelCount{};
+	bool isMatch{};
+};
+
+Comparison CompareImages(const Image& image, const Image& reference, const TestOptions& options, Image* pDiffImage = nullptr)
+{
+	Comparison comparison{};
+	if (image.width != reference.width || image.height != reference.height)
+	{
+		comparison.badPixelCount = image.width * image.height;
+		return comparison;
+	}
+
+	// Bad pixels in red, everything else dimmed so the diff can be placed
+	if (pDiffImage != nullptr) *pDiffImage = Image{ image.width, image.height, std::vector<uint8_t>(image.pixels.size()) };
+
+	const int pixelCount{ image.width * image.height };
+	for (int pixelIdx{}; pixelIdx < pixelCount; ++pixelIdx)
+	{
+		int pixelDifference{};
+		for (int channel{}; channel < 3; ++channel)
+		{
+			const size_t byteIdx{ static_cast<size_t>(pixelIdx) * 3 + channel };
+			pixelDifference = std::max(pixelDifference, std::abs(image.pixels[byteIdx] - reference.pixels[byteIdx]));
+		}
+
+		comparison.maxChannelDifference = std::max(comparison.maxChannelDifference, pixelDifference);
+		const bool isBadPixel{ pixelDifference > options.channelTolerance };
+		if (isBadPixel) ++comparison.badPixelCount;
+
+		if (pDiffImage != nullptr)
+		{
+			uint8_t* pPixel{ &pDiffImage->pixels[static_cast<size_t>(pixelIdx) * 3] };
+			const uint8_t dimmedValue{ static_cast<uint8_t>(reference.pixels[static_cast<size_t>(pixelIdx) * 3 + 1] / 4) };
+			pPixel[0] = isBadPixel ? 255 : dimmedValue;
+			pPixel[1] = isBadPixel ? 0 : dimmedValue;
+			pPixel[2] = isBadPixel ? 0 : dimmedValue;
+		}
+	}
+
+	comparison.isMatch = comparison.badPixelCount <= static_cast<int>(options.maxBadPixelFraction * pixelCount);
+	return comparison;
+}
+
+// -- Scenes -- //
+
+struct TestScene
+{
+	std::string name{};
+	std::vector<VS_INPUT> vertices{};
+	std::vector<uint32_t> indices{};
+	Matrix worldMatrix{};
+};
+
+// Scenes are written as OBJ and loaded through ParseOBJ, so they get the same winding flip and tangents as the vehicle
+class ObjBuilder final
+{
+public:
+	// Texture::Sample doesn't wrap, uv in [0, 1] gets pulled in from the edges
+	uint32_t AddVertex(const Vector3& position, const Vector2& uv, const Vector3& normal)
+	{
+		const Vector2 safeUV{ 0.01f + uv.x * 0.98f, 0.01f + uv.y * 0.98f };
+
+		char line[192]{};
+		std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+			position.x, position.y, position.z, safeUV.x, safeUV.y, normal.x, normal.y, normal.z);
+		m_Text += line;
+		return ++m_VertexCount;
+	}
+	void AddTriangle(uint32_t v0, uint32_t v1, uint32_t v2)
+	{
+		char line[96]{};
+		std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", v0, v0, v0, v1, v1, v1, v2, v2, v2);
+		m_Text += line;
+	}
+	void AddQuad(uint32_t v0, uint32_t v1, uint32_t v2, uint32_t v3)
+	{
+		AddTriangle(v0, v1, v2);
+		AddTriangle(v0, v2, v3);
+	}
+
+	bool Load(const std::string& fileName, TestScene& scene) const
+	{
+		{
+			std::ofstream file{ fileName };
+			if (!file) return false;
+			file << m_Text;
+		}
+		return Utils::ParseOBJ(fileName, scene.vertices, scene.indices);
+	}
+
+private:
+	std::string m_Text{};
+	uint32_t m_VertexCount{};
+};
+
+void AddSphere(ObjBuilder& builder, float radius, int ringCount, int segmentCount)
+{
+	std::vector<uint32_t> vertexIndices{};
+	for (int ringIdx{}; ringIdx <= ringCount; ++ringIdx)
+	{
+		const float v{ ringIdx / static_cast<float>(ringCount) };
+		const float polarAngle{ v * PI };
+		for (int segmentIdx{}; segmentIdx <= segmentCount; ++segmentIdx)
+		{
+			const float u{ segmentIdx / static_cast<float>(segmentCount) };
+			const float azimuth{ u * PI_2 };
+
+			// Poles get their u nudged to the middle of the segment, so no triangle has degenerate uvs
+			const float uvU{ (ringIdx == 0 || ringIdx == ringCount) ? std::min(u + 0.5f / segmentCount, 1.f) : u };
+
+			const Vector3 normal{ std::sin(polarAngle) * std::cos(azimuth), std::cos(polarAngle), std::sin(polarAngle) * std::sin(azimuth) };
+			vertexIndices.push_back(builder.AddVertex(normal * radius, Vector2{ uvU, v }, normal));
+		}
+	}
+
+	const int rowSize{ segmentCount + 1 };
+	for (int ringIdx{}; ringIdx < ringCount; ++ringIdx)
+	{
+		for (int segmentIdx{}; segmentIdx < segmentCount; ++segmentIdx)
+		{
+			const uint32_t v0{ vertexIndices[ringIdx * rowSize + segmentIdx] };
+			const uint32_t v1{ vertexIndices[ringIdx * rowSize + segmentIdx + 1] };
+			const uint32_t v2{ vertexIndices[(ringIdx + 1) * rowSize + segmentIdx + 1] };
+			const uint32_t v3{ vertexIndices[(ringIdx + 1) * rowSize + segmentIdx] };
+
+			if (ringIdx != 0) builder.AddTriangle(v0, v1, v2);
+			if (ringIdx != ringCount - 1) builder.AddTriangle(v0, v2, v3);
+		}
+	}
+}
+
+// Grid of quads, spanned by two axes from a corner, facing towards axisU x axisV
+void AddGrid(ObjBuilder& builder, const Vector3& corner, const Vector3& axisU, const Vector3& axisV, int cellCountU, int cellCountV)
+{
+	const Vector3 normal{ Vector3::Cross(axisU, axisV).Normalized() };
+
+	std::vector<uint32_t> vertexIndices{};
+	for (int rowIdx{}; rowIdx <= cellCountV; ++rowIdx)
+	{
+		const float v{ rowIdx / static_cast<float>(cellCountV) };
+		for (int columnIdx{}; columnIdx <= cellCountU; ++columnIdx)
+		{
+			const float u{ columnIdx / static_cast<float>(cellCountU) };
+			vertexIndices.push_back(builder.AddVertex(corner + axisU * u + axisV * v, Vector2{ u, v }, normal));
+		}
+	}
+
+	const int rowSize{ cellCountU + 1 };
+	for (int rowIdx{}; rowIdx < cellCountV; ++rowIdx)
+	{
+		for (int columnIdx{}; columnIdx < cellCountU; ++columnIdx)
+		{
+			builder.AddQuad(
+				vertexIndices[rowIdx * rowSize + columnIdx],
+				vertexIndices[rowIdx * rowSize + columnIdx + 1],
+				vertexIndices[(rowIdx + 1) * rowSize + columnIdx + 1],
+				vertexIndices[(rowIdx + 1) * rowSize + columnIdx]);
+		}
+	}
+}
+
+void AddCube(ObjBuilder& builder, float halfSize)
+{
+	// Every face as a 2x2 grid, so faces share no vertices and keep hard normals
+	const float size{ halfSize * 2.f };
+	AddGrid(builder, { -halfSize, -halfSize, -halfSize }, { 0, size, 0 }, { size, 0, 0 }, 2, 2);
+	AddGrid(builder, { halfSize, -halfSize, halfSize }, { 0, size, 0 }, { -size, 0, 0 }, 2, 2);
+	AddGrid(builder, { halfSize, -halfSize, -halfSize }, { 0, size, 0 }, { 0, 0, size }, 2, 2);
+	AddGrid(builder, { -halfSize, -halfSize, halfSize }, { 0, size, 0 }, { 0, 0, -size }, 2, 2);
+	AddGrid(builder, { -halfSize, halfSize, -halfSize }, { 0, 0, size }, { size, 0, 0 }, 2, 2);
+	AddGrid(builder, { -halfSize, -halfSize, halfSize }, { 0, 0, -size }, { size, 0, 0 }, 2, 2);
+}
+
+bool CreateScenes(const TestOptions& options, std::vector<TestScene>& scenes)
+{
+	const Matrix translationMatrix{ Matrix::CreateTranslation(0.f, 0.f, 50.f) };
+	const auto loadScene = [&](const char* name, const ObjBuilder& builder, const Matrix& worldMatrix)
+		{
+			TestScene scene{ name };
+			scene.worldMatrix = worldMatrix;
+			if (builder.Load(options.outputDirectory + "/" + name + ".obj", scene) == false)
+			{
+				std::cout << "Failed to create scene " << name << std::endl;
+				return false;
+			}
+			scenes.push_back(std::move(scene));
+			return true;
+		};
+
+	// Smooth normals and a uv seam
+	ObjBuilder sphereBuilder{};
+	AddSphere(sphereBuilder, 14.f, 16, 32);
+	if (!loadScene("sphere", sphereBuilder, Matrix::CreateRotationX(0.3f) * Matrix::CreateRotationY(0.7f) * translationMatrix)) return false;
+
+	// Hard edges, culling shows the inside
+	ObjBuilder cubeBuilder{};
+	AddCube(cubeBuilder, 9.f);
+	if (!loadScene("cube", cubeBuilder, Matrix::CreateRotationY(0.8f) * Matrix::CreateRotationX(0.5f) * translationMatrix)) return false;
+
+	// Floor that runs behind the camera, for near plane clipping and triangles much bigger than a tile
+	ObjBuilder floorBuilder{};
+	AddGrid(floorBuilder, { -80.f, -10.f, -80.f }, { 0, 0, 160.f }, { 160.f, 0, 0 }, 8, 8);
+	AddGrid(floorBuilder, { -30.f, -10.f, -40.f }, { 60.f, 0, 0 }, { 0, 30.f, 0 }, 4, 2);
+	if (!loadScene("floor", floorBuilder, Matrix::CreateRotationY(0.25f) * translationMatrix)) return false;
+
+	// A pixel or two per triangle
+	ObjBuilder denseBuilder{};
+	AddGrid(denseBuilder, { -14.f, -10.f, 0.f }, { 28.f, 0, 0 }, { 0, 20.f, 0 }, 96, 64);
+	if (!loadScene("dense", denseBuilder, Matrix::CreateRotationY(0.4f) * Matrix::CreateTranslation(0.f, 0.f, 40.f))) return false;
+
+	// The vehicle isn't part of the repository, only test it when it's there
+	TestScene vehicleScene{ "vehicle" };
+	if (Utils::ParseOBJ(options.vehiclePath, vehicleScene.vertices, vehicleScene.indices))
+	{
+		vehicleScene.worldMatrix = Matrix::CreateRotationY(0.6f) * translationMatrix;
+		scenes.push_back(std::move(vehicleScene));
+	}
+	else std::cout << "SKIP  vehicle, no model at " << options.vehiclePath << std::endl;
+
+	return true;
+}
+
+// Generated, so the references don't depend on how SDL_image decodes
+SDL_Surface* CreateTextureSurface(int size, const std::function<void(int, int, uint8_t&, uint8_t&, uint8_t&)>& getTexel)
+{
+	SDL_Surface* pSurface{ SDL_CreateRGBSurface(0, size, size, 32, 0, 0, 0, 0) };
+	uint32_t* pPixels{ static_cast<uint32_t*>(pSurface->pixels) };
+
+	for (int py{}; py < size; ++py)
+	{
+		for (int px{}; px < size; ++px)
+		{
+			uint8_t r{}, g{}, b{};
+			getTexel(px, py, r, g, b);
+			pPixels[py * size + px] = SDL_MapRGB(pSurface->format, r, g, b);
+		}
+	}
+
+	return pSurface;
+}
+
+// -- Cases -- //
+
+// Toggles report to std::cout, keeps the test output readable
+class QuietScope final
+{
+public:
+	QuietScope() : m_pBuffer{ std::cout.rdbuf(m_Sink.rdbuf()) } {}
+	~QuietScope() { std::cout.rdbuf(m_pBuffer); }
+
+	QuietScope(const QuietScope&) = delete;
+	QuietScope(QuietScope&&) noexcept = delete;
+	QuietScope& operator=(const QuietScope&) = delete;
+	QuietScope& operator=(QuietScope&&) noexcept = delete;
+
+private:
+	std::ostringstream m_Sink{};
+	std::streambuf* m_pBuffer{};
+};
+
+// Fast path turned on for one render and back off again, has to match the default render pixel for pixel
+struct Variant
+{
+	const char* name{};
+	std::function<void(SoftwareRenderer&)> enable{};
+	std::function<void(SoftwareRenderer&)> disable{};
+};
+
+// Same order as SoftwareRenderer's toggle, which starts at combined
+constexpr const char* g_ShadingModeNames[]{ "observed_area", "diffuse", "specular", "combined" };
+constexpr const char* g_CullingModeNames[]{ "back", "front", "none" };
+
+// Output features with their own references, only rendered in combined with the normal map
+struct Feature
+{
+	const char* suffix{};
+	bool useMsaa{};
+	float resolutionScale{ 1.f };
+
+	// Same order as SoftwareRenderer's toggle: full, adaptive, 2x2
+	int shadingRateIdx{};
+
+	// Same order as SoftwareRenderer's toggle: off, overdraw, depth failures, tile cost
+	// Only overdraw is tested, the others depend on culling and timing
+	int heatmapIdx{};
+
+	// Frames rendered before the compared one, adaptive rates follow the frame before
+	int settleFrameCount{};
+};
+constexpr Feature g_Features[]{ { "", false, 1.f, 0, 0, 0 }, { "_msaa", true, 1.f, 0, 0, 0 }, { "_scaled", false, 0.75f, 0, 0, 0 },
+	{ "_adaptive", false, 1.f, 1, 0, 2 }, { "_coarse", false, 1.f, 2, 0, 0 }, { "_overdraw", false, 1.f, 0, 1, 0 } };
+
+struct CaseResult
+{
+	std::string name{};
+	std::string status{};
+	double renderMs{};
+	Comparison comparison{};
+	std::string failedVariants{};
+};
+
+bool WriteResults(const std::string& fileName, const std::vector<CaseResult>& results)
+{
+	std::ofstream file{ fileName };
+	if (!file) return false;
+
+	file << "case,status,render_ms,max_channel_diff,bad_pixels,failed_variants\n";
+	for (const CaseResult& result : results)
+	{
+		file << result.name << ',' << result.status << ',' << result.renderMs << ','
+			<< result.comparison.maxChannelDifference << ',' << result.comparison.badPixelCount << ',' << result.failedVariants << '\n';
+	}
+
+	return file.good();
+}
+
+// -- Main -- //
+
+void PrintUsage()
+{
+	std::cout << "Usage: SoftwareRasterizerGoldenTests [options]" << std::endl;
+	std::cout << '\t' << "--references <dir>" << '\t' << "Reference images (tests/golden)" << std::endl;
+	std::cout << '\t' << "--vehicle <path>" << '\t' << "Vehicle OBJ, its cases are skipped without it (source/Resources/vehicle.obj)" << std::endl;
+	std::cout << '\t' << "--output <dir>" << '\t' << '\t' << "Images and diffs of failed cases (golden_output)" << std::endl;
+	std::cout << '\t' << "--results <path>" << '\t' << "Status and render time of every case (golden_results.csv)" << std::endl;
+	std::cout << '\t' << "--filter <text>" << '\t' << '\t' << "Only cases with this in their name" << std::endl;
+	std::cout << '\t' << "--tolerance <0-255>" << '\t' << "Per-channel difference that still matches (2)" << std::endl;
+	std::cout << '\t' << "--bad-pixels <fraction>" << '\t' << "Fraction of pixels allowed over the tolerance (0.001)" << std::endl;
+	std::cout << '\t' << "--update <0|1>" << '\t' << '\t' << "Write every reference from the current output, missing references fail without it (0)" << std::endl;
+}
+
+bool ParseArguments(int argc, char* args[], TestOptions& options)
+{
+	for (int argIdx{ 1 }; argIdx < argc; ++argIdx)
+	{
+		const std::string option{ args[argIdx] };
+		if (option == "--help")
+		{
+			return false;
+		}
+
+		// Every option takes exactly one value
+		if (argIdx + 1 >= argc)
+		{
+			std::cout << "Missing value for " << option << std::endl;
+			return false;
+		}
+		const char* value{ args[++argIdx] };
+
+		if (option == "--references") options.referenceDirectory = value;
+		else if (option == "--vehicle") options.vehiclePath = value;
+		else if (option == "--output") options.outputDirectory = value;
+		else if (option == "--results") options.resultsPath = value;
+		else if (option == "--filter") options.filter = value;
+		else if (option == "--tolerance") options.channelTolerance = std::atoi(value);
+		else if (option == "--bad-pixels") options.maxBadPixelFraction = static_cast<float>(std::atof(value));
+		else if (option == "--update") options.updateReferences = std::atoi(value) != 0;
+		else
+		{
+			std::cout << "Unknown option " << option << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char* args[])
+{
+	TestOptions options{};
+	if (ParseArguments(argc, args, options) == false)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::filesystem::create_directories(options.outputDirectory);
+
+	// References only ever get written on request
+	if (options.updateReferences) std::filesystem::create_directories(options.referenceDirectory);
+
+	std::vector<TestScene> scenes{};
+	if (CreateScenes(options, scenes) == false) return 1;
+
+	// Checkers, bumps and stripes, so sampling and the normal map both show up
+	Texture diffuseTexture{ CreateTextureSurface(128, [](int x, int y, uint8_t& r, uint8_t& g, uint8_t& b)
+		{
+			const bool isDark{ ((x / 16 + y / 16) & 1) != 0 };
+			r = static_cast<uint8_t>(isDark ? 60 + x / 4 : 220);
+			g = static_cast<uint8_t>(isDark ? 90 : 140 + y / 4);
+			b = static_cast<uint8_t>(isDark ? 180 : 70);
+		}) };
+	Texture normalTexture{ CreateTextureSurface(128, [](int x, int y, uint8_t& r, uint8_t& g, uint8_t& b)
+		{
+			// Triangle wave bumps, tangent-space xy tilted by up to about 30 degrees
+			const int bumpX{ std::abs((x % 32) - 16) - 8 };
+			const int bumpY{ std::abs((y % 32) - 16) - 8 };
+			r = static_cast<uint8_t>(128 + bumpX * 8);
+			g = static_cast<uint8_t>(128 + bumpY * 8);
+			b = 220;
+		}) };
+	Texture specularTexture{ CreateTextureSurface(128, [](int x, int, uint8_t& r, uint8_t& g, uint8_t& b)
+		{
+			r = g = b = static_cast<uint8_t>(((x / 8) & 1) != 0 ? 230 : 40);
+		}) };
+	Texture glossinessTexture{ CreateTextureSurface(128, [](int, int y, uint8_t& r, uint8_t& g, uint8_t& b)
+		{
+			r = g = b = static_cast<uint8_t>(y * 2);
+		}) };
+
+	Camera camera{ g_ImageWidth / static_cast<float>(g_ImageHeight), { 0,0,0.f }, 45.f };
+
+	// The tolerance is only for the stored references, fast paths take the same steps in the same order
+	TestOptions exactOptions{ options };
+	exactOptions.channelTolerance = 0;
+	exactOptions.maxBadPixelFraction = 0.f;
+
+	std::vector<CaseResult> results{};
+	int failedCaseCount{};
+
+	for (const TestScene& scene : scenes)
+	{
+		Matrix worldMatrix{ scene.worldMatrix };
+		bool useClearColorBackground{ false };
+		CullingMode cullingMode{ backFace };
+
+		SoftwareRenderer softwareRenderer{
+			nullptr, g_ImageWidth, g_ImageHeight,
+			scene.vertices, scene.indices,
+			&diffuseTexture, &normalTexture, &specularTexture, &glossinessTexture,
+			&camera,
+			&worldMatrix, &useClearColorBackground, &cullingMode };
+		softwareRenderer.SetThreadCount(g_ThreadCount);
+		softwareRenderer.Update(nullptr);
+
+		const std::vector<Variant> variants{
+			// Nothing changes, so whatever carries over between frames, like adaptive shading rates, has to have settled
+			{ "repeat", [](SoftwareRenderer&) {}, [](SoftwareRenderer&) {} },
+#if defined(__AVX2__)
+			{ "scalar", [](SoftwareRenderer& renderer) { renderer.ToggleSimd(); }, [](SoftwareRenderer& renderer) { renderer.ToggleSimd(); } },
+#endif
+			{ "single_thread", [](SoftwareRenderer& renderer) { renderer.SetThreadCount(1); }, [](SoftwareRenderer& renderer) { renderer.SetThreadCount(g_ThreadCount); } },
+			{ "visibility_buffer", [](SoftwareRenderer& renderer) { renderer.ToggleVisibilityBuffer(); }, [](SoftwareRenderer& renderer) { renderer.ToggleVisibilityBuffer(); } },
+			{ "depth_compression", [](SoftwareRenderer& renderer) { renderer.ToggleDepthCompression(); }, [](SoftwareRenderer& renderer) { renderer.ToggleDepthCompression(); } },
+			{ "present_ring", [](SoftwareRenderer& renderer) { renderer.SetPresentBufferCount(3); }, [](SoftwareRenderer& renderer) { renderer.SetPresentBufferCount(1); } },
+		};
+
+		// Renderer starts out in combined with the normal map on, MSAA off, at full resolution and full shading rate
+		int shadingModeIdx{ 3 };
+		bool useNormalMap{ true };
+		bool useMsaa{ false };
+		int shadingRateIdx{};
+		int heatmapIdx{};
+
+		for (int nextShadingModeIdx{}; nextShadingModeIdx < 4; ++nextShadingModeIdx)
+		{
+			for (bool nextUseNormalMap : { true, false })
+			{
+				for (int cullingModeIdx{}; cullingModeIdx < 3; ++cullingModeIdx)
+				{
+					for (const Feature& feature : g_Features)
+					{
+						// Edges and sampling are what these change, one shading mode is enough
+						if (feature.suffix[0] != '\0' && (nextShadingModeIdx != 3 || nextUseNormalMap == false)) continue;
+
+						CaseResult result{};
+						result.name = scene.name + "_" + g_ShadingModeNames[nextShadingModeIdx] + "_" + g_CullingModeNames[cullingModeIdx]
+							+ (nextUseNormalMap ? "_normal_map" : "_no_normal_map") + feature.suffix;
+						if (result.name.find(options.filter) == std::string::npos) continue;
+
+						{
+							QuietScope quietScope{};
+							while (shadingModeIdx != nextShadingModeIdx)
+							{
+								softwareRenderer.ToggleShadingMode();
+								shadingModeIdx = (shadingModeIdx + 1) % 4;
+							}
+							if (useNormalMap != nextUseNormalMap)
+							{
+								softwareRenderer.ToggleNormalMap();
+								useNormalMap = nextUseNormalMap;
+							}
+							if (useMsaa != feature.useMsaa)
+							{
+								softwareRenderer.ToggleMsaa();
+								useMsaa = feature.useMsaa;
+							}
+							softwareRenderer.SetResolutionScale(feature.resolutionScale);
+
+							// Adaptive rates carry over from the case before, a full cycle back into the mode starts them at full rate again
+							if (feature.settleFrameCount > 0 && shadingRateIdx == feature.shadingRateIdx)
+							{
+								for (int toggleIdx{}; toggleIdx < 3; ++toggleIdx) softwareRenderer.ToggleShadingRate();
+							}
+							while (shadingRateIdx != feature.shadingRateIdx)
+							{
+								softwareRenderer.ToggleShadingRate();
+								shadingRateIdx = (shadingRateIdx + 1) % 3;
+							}
+							while (heatmapIdx != feature.heatmapIdx)
+							{
+								softwareRenderer.ToggleHeatmap();
+								heatmapIdx = (heatmapIdx + 1) % 4;
+							}
+						}
+						cullingMode = static_cast<CullingMode>(cullingModeIdx);
+
+						for (int frameIdx{}; frameIdx < feature.settleFrameCount; ++frameIdx) softwareRenderer.Render();
+						softwareRenderer.Render();
+						const Image image{ CaptureBackBuffer(softwareRenderer) };
+
+						// A missing reference fails the case, new cases and the vehicle get recorded with --update 1
+						const std::string referencePath{ options.referenceDirectory + "/" + result.name + ".png" };
+						Image reference{};
+						if (options.updateReferences)
+						{
+							if (WritePng(referencePath, image) == false)
+							{
+								std::cout << "Failed to write " << referencePath << std::endl;
+								return 1;
+							}
+							reference = image;
+							result.status = "RECORDED";
+						}
+						else if (ReadPng(referencePath, reference) == false)
+						{
+							WritePng(options.outputDirectory + "/" + result.name + "_actual.png", image);
+
+							result.status = "FAIL";
+							++failedCaseCount;
+							std::cout << result.status << '\t' << result.name << " (no reference at " << referencePath << ", --update 1 records it)" << std::endl;
+
+							results.push_back(std::move(result));
+							continue;
+						}
+
+						Image diffImage{};
+						result.comparison = CompareImages(image, reference, options, &diffImage);
+						if (result.comparison.isMatch == false)
+						{
+							WritePng(options.outputDirectory + "/" + result.name + "_actual.png", image);
+							WritePng(options.outputDirectory + "/" + result.name + "_diff.png", diffImage);
+						}
+
+						// Every fast path against the default render
+						for (const Variant& variant : variants)
+						{
+							Image variantImage{};
+							{
+								QuietScope quietScope{};
+								variant.enable(softwareRenderer);
+								softwareRenderer.Render();
+								variantImage = CaptureBackBuffer(softwareRenderer);
+								variant.disable(softwareRenderer);
+							}
+
+							const Comparison variantComparison{ CompareImages(variantImage, image, exactOptions) };
+							if (variantComparison.isMatch) continue;
+
+							if (result.failedVariants.empty() == false) result.failedVariants += ' ';
+							result.failedVariants += variant.name;
+							result.comparison.maxChannelDifference = std::max(result.comparison.maxChannelDifference, variantComparison.maxChannelDifference);
+							result.comparison.badPixelCount = std::max(result.comparison.badPixelCount, variantComparison.badPixelCount);
+							WritePng(options.outputDirectory + "/" + result.name + "_" + variant.name + ".png", variantImage);
+						}
+
+						// Median of a few frames, next to the result so slowdowns show up with the pixels
+						std::vector<double> frameMilliseconds{};
+						for (int frameIdx{}; frameIdx < options.timingFrameCount; ++frameIdx)
+						{
+							softwareRenderer.Render();
+							frameMilliseconds.push_back(softwareRenderer.GetFrameTimings().totalMs);
+						}
+						std::sort(frameMilliseconds.begin(), frameMilliseconds.end());
+						result.renderMs = frameMilliseconds[frameMilliseconds.size() / 2];
+
+						const bool isPassed{ result.comparison.isMatch && result.failedVariants.empty() };
+						if (isPassed == false)
+						{
+							result.status = "FAIL";
+							++failedCaseCount;
+						}
+						else if (result.status.empty()) result.status = "PASS";
+
+						char timingText[32]{};
+						std::snprintf(timingText, sizeof(timingText), "%8.3f ms", result.renderMs);
+						std::cout << result.status << '\t' << timingText << '\t' << result.name;
+						if (isPassed == false)
+						{
+							std::cout << " (max difference " << result.comparison.maxChannelDifference << ", "
+								<< result.comparison.badPixelCount << " bad pixels";
+							if (result.failedVariants.empty() == false) std::cout << ", failed " << result.failedVariants;
+							std::cout << ")";
+						}
+						std::cout << std::endl;
+
+						results.push_back(std::move(result));
+					}
+				}
+			}
+		}
+	}
+
+	if (WriteResults(options.resultsPath, results) == false)
+	{
+		std::cout << "Failed to write " << options.resultsPath << std::endl;
+	}
+
+	std::cout << results.size() - failedCaseCount << " of " << results.size() << " cases passed" << std::endl;
+	return failedCaseCount == 0 ? 0 : 1;
+}